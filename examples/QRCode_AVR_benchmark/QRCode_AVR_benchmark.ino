@@ -0,0 +1,237 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+This example measures the cost of generating and drawing QR Codes
+on an AVR board, in CPU cycles. It encodes a short text at versions
+1 to 10 with each error correction level, then generates and draws
+one QR Code on a display that only exists in memory.
+For each one it prints on Serial Monitor:
+- the cycles spent in each phase of the encoder
+- the peak stack usage, measured by painting the free memory
+- the free SRAM left at that peak
+
+Cycles are counted with Timer1 (16 bits, no prescaler, plus an overflow
+counter). The millis() interrupt is paused during measurements.
+
+It runs on an Arduino Uno / Mega, or without a board under simavr:
+  arduino-cli compile --fqbn arduino:avr:uno --output-dir build examples/QRCode_AVR_benchmark
+  simavr -m atmega328p -f 16000000 build/QRCode_AVR_benchmark.ino.elf
+Use -m atmega2560 (and --fqbn arduino:avr:mega) for a Mega.
+The Serial output shows on the simulator's console, and the program
+puts the CPU to sleep when done, which ends the simulation.
+
+To see the cost of version detection, run it again with
+QRCODE_GENERATOR_USE_LESS_MEMORY defined in QRCodeSettings.h
+(the last line, generateData, is the only one that changes).
+
+*************************************************/
+
+
+#include <QRCodeGFX.h>
+#include <QRCodeRecordingGFX.h>
+#include <avr/sleep.h>
+
+#ifndef __AVR__
+#error "This example counts AVR cycles, it needs an AVR board (or simavr)"
+#endif
+
+#define MAX_VERSION 10
+#define STACK_PAINT 0xA5
+
+// 7 bytes fit version 1 even with High error correction
+const char text[] = "QRCode!";
+
+uint8_t qrcodeBuffer[qrcodegen_BUFFER_LEN_FOR_VERSION(MAX_VERSION)];
+uint8_t tempBuffer[qrcodegen_BUFFER_LEN_FOR_VERSION(MAX_VERSION)];
+
+// Cycle counter
+
+volatile uint16_t timerOverflows = 0;
+
+ISR(TIMER1_OVF_vect) {
+  timerOverflows++;
+}
+
+void startCycleCounter() {
+  TCCR1A = 0;
+  TCCR1B = _BV(CS10); // no prescaler: one tick per CPU cycle
+  TCNT1 = 0;
+  TIFR1 = _BV(TOV1);
+  TIMSK1 = _BV(TOIE1);
+}
+
+uint32_t cycles() {
+  uint8_t oldSREG = SREG;
+  cli();
+  uint16_t ticks = TCNT1;
+  uint16_t overflows = timerOverflows;
+  // An overflow may be pending while interrupts are off
+  if ((TIFR1 & _BV(TOV1)) && ticks < 0x8000) {
+    overflows++;
+  }
+  SREG = oldSREG;
+  return ((uint32_t)overflows << 16) | ticks;
+}
+
+void pauseMillis() {
+  TIMSK0 &= ~_BV(TOIE0);
+}
+
+void resumeMillis() {
+  TIMSK0 |= _BV(TOIE0);
+}
+
+// Stack painting
+
+extern char __heap_start;
+extern char *__brkval;
+
+uint8_t* heapEnd() {
+  return (uint8_t *)(__brkval != 0 ? __brkval : &__heap_start);
+}
+
+// Fills the free memory between the heap and the stack, keeping a margin for this call
+void __attribute__((noinline)) paintStack() {
+  uint8_t *top = (uint8_t *)SP - 32;
+  for (uint8_t *p = heapEnd(); p < top; p++) {
+    *p = STACK_PAINT;
+  }
+}
+
+// Lowest address the stack reached since the last paint
+uint8_t* stackLowWater() {
+  uint8_t *p = heapEnd();
+  while (*p == STACK_PAINT && p < (uint8_t *)SP) {
+    p++;
+  }
+  return p;
+}
+
+void printMemory() {
+  uint8_t *low = stackLowWater();
+  Serial.print(" stack=");
+  Serial.print((unsigned)((uint8_t *)RAMEND - low + 1));
+  Serial.print(" free=");
+  Serial.println((unsigned)(low - heapEnd()));
+}
+
+// Workloads
+
+const char *phaseNames[] = {"segments", "ecc", "placement", "masks", "final"};
+
+void benchmarkEncode(enum qrcodegen_Ecc ecl, uint8_t version) {
+  uint8_t segmentBuffer[sizeof(text) - 1];
+  struct qrcodegen_Segment segment = qrcodegen_makeBytes((const uint8_t *)text, sizeof(text) - 1, segmentBuffer);
+  struct qrcodegen_Encoder encoder;
+  uint32_t phaseCycles[qrcodegen_EncodePhase_DONE] = {0};
+
+  // Serial sends from an interrupt: let the last line go out, or its interrupts land in the measurement
+  Serial.flush();
+  paintStack();
+  pauseMillis();
+
+  uint32_t start = cycles();
+  bool success = qrcodegen_beginEncode(&encoder, &segment, 1, ecl, version, version, qrcodegen_Mask_AUTO, false,
+                                       tempBuffer, qrcodeBuffer, NULL);
+  uint32_t beginCycles = cycles() - start;
+
+  enum qrcodegen_EncodePhase phase = qrcodegen_EncodePhase_SEGMENTS;
+  while (success && phase != qrcodegen_EncodePhase_DONE) {
+    start = cycles();
+    enum qrcodegen_EncodePhase next = qrcodegen_encodeStep(&encoder);
+    phaseCycles[phase] += cycles() - start;
+    phase = next;
+  }
+
+  resumeMillis();
+
+  if (!success) {
+    Serial.println("failed");
+    return;
+  }
+
+  uint32_t total = beginCycles;
+  for (uint8_t i = 0; i < qrcodegen_EncodePhase_DONE; i++) {
+    total += phaseCycles[i];
+  }
+
+  Serial.print(version);
+  Serial.print(" total=");
+  Serial.print(total);
+  Serial.print(" begin=");
+  Serial.print(beginCycles);
+  for (uint8_t i = 0; i < qrcodegen_EncodePhase_DONE; i++) {
+    Serial.print(' ');
+    Serial.print(phaseNames[i]);
+    Serial.print('=');
+    Serial.print(phaseCycles[i]);
+  }
+  printMemory();
+}
+
+void benchmarkDraw() {
+  QRCodeRecordingGFX display(240, 240, QRCodeRecordingGFX::ILI9341, false);
+  QRCodeGFX qrcode(display);
+  qrcode.getGenerator().setBuffers(qrcodeBuffer, tempBuffer, sizeof(qrcodeBuffer)).setVersionRange(1, MAX_VERSION);
+  qrcode.setScale(4);
+
+  Serial.flush();
+  paintStack();
+  pauseMillis();
+  uint32_t start = cycles();
+  bool success = qrcode.generateData(text);
+  uint32_t generateCycles = cycles() - start;
+  resumeMillis();
+
+  Serial.print("generateData=");
+  Serial.print(generateCycles);
+  printMemory();
+  if (!success) {
+    return;
+  }
+
+  Serial.flush();
+  paintStack();
+  pauseMillis();
+  start = cycles();
+  qrcode.draw(0, 0);
+  uint32_t drawCycles = cycles() - start;
+  resumeMillis();
+
+  Serial.print("draw=");
+  Serial.print(drawCycles);
+  Serial.print(" calls=");
+  Serial.print(display.getCounters().drawPixelCalls + display.getCounters().fillRectCalls);
+  printMemory();
+}
+
+void setup() {
+  Serial.begin(115200);
+  startCycleCounter();
+
+  const char *levelNames[] = {"Low", "Medium", "Quartile", "High"};
+  for (uint8_t level = 0; level < 4; level++) {
+    Serial.print("\nError correction ");
+    Serial.println(levelNames[level]);
+    for (uint8_t version = 1; version <= MAX_VERSION; version++) {
+      benchmarkEncode((enum qrcodegen_Ecc)level, version);
+    }
+  }
+
+  Serial.println("\nQRCodeGFX with a mock ILI9341");
+  benchmarkDraw();
+
+  Serial.println("\nDone");
+  Serial.flush();
+
+  // Sleeping with interrupts off ends a simavr run
+  set_sleep_mode(SLEEP_MODE_PWR_DOWN);
+  cli();
+  sleep_mode();
+}
+
+void loop() {
+}
@@ -0,0 +1,85 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+This example encodes a batch of label QR Codes, first in a single thread
+and then with a thread pool using both ESP32 cores.
+It prints both timings on Serial Monitor and checks that the results match.
+No display is needed.
+
+It was written for a dual core ESP32, but so far it has only been run
+on a hosted build (a computer), where the results matched.
+The thread pool is also available on hosted builds, where it uses
+one worker per hardware thread by default.
+
+*************************************************/
+
+
+#include <QRCodeGFX.h>
+
+#ifndef QRCODE_THREAD_POOL_ENABLED
+#error "This example needs an ESP32, other boards have no threads"
+#endif
+
+#define LABEL_COUNT 48
+#define MAX_VERSION 4
+
+QRCodeGenerator generator;
+
+char texts[LABEL_COUNT][40];
+uint8_t serialOutput[LABEL_COUNT][qrcodegen_BUFFER_LEN_FOR_VERSION(MAX_VERSION)];
+uint8_t parallelOutput[LABEL_COUNT][qrcodegen_BUFFER_LEN_FOR_VERSION(MAX_VERSION)];
+QRCodeBatchItem items[LABEL_COUNT];
+
+unsigned long encode(uint8_t output[][qrcodegen_BUFFER_LEN_FOR_VERSION(MAX_VERSION)], QRCodeExecutor *executor) {
+  for (int i = 0; i < LABEL_COUNT; i++) {
+    items[i].text = texts[i];
+    items[i].qrcode = output[i];
+    items[i].size = sizeof(output[i]);
+  }
+
+  unsigned long start = micros();
+  bool success = generator.generateBatch(items, LABEL_COUNT, executor);
+  unsigned long elapsed = micros() - start;
+
+  if (!success) {
+    Serial.println("Some labels could not be encoded!");
+  }
+  return elapsed;
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  generator.setVersionRange(1, MAX_VERSION)
+           .setErrorCorrectionLevel(QRCodeECCLevel::Medium);
+
+  for (int i = 0; i < LABEL_COUNT; i++) {
+    snprintf(texts[i], sizeof(texts[i]), "https://example.com/label/%05d", i * 37);
+  }
+
+  // NULL runs the whole batch in this thread
+  unsigned long serialTime = encode(serialOutput, NULL);
+
+  // One worker per core (this thread is one of them)
+  QRCodeThreadPool pool(2);
+  unsigned long parallelTime = encode(parallelOutput, &pool);
+
+  Serial.print("1 worker:  ");
+  Serial.print(serialTime);
+  Serial.println(" us");
+  Serial.print("2 workers: ");
+  Serial.print(parallelTime);
+  Serial.println(" us");
+  Serial.print("Speedup:   ");
+  Serial.println((float)serialTime / parallelTime);
+
+  // The results never depend on the number of workers
+  bool same = memcmp(serialOutput, parallelOutput, sizeof(serialOutput)) == 0;
+  Serial.println(same ? "Results match" : "Results differ!");
+}
+
+void loop() {
+}
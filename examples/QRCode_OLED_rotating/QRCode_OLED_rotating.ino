@@ -5,7 +5,8 @@ MIT License
 https://github.com/wallysalami/QRCodeGFX
 
 This example will keep drawing a rotating QR Code on the screen.
-It shows how you can generate the QR Code data once and draw it many times.
+It shows how you can generate the QR Code data once and draw it many times,
+from a display list that doesn't need to walk the QR Code modules again.
 
 This program was tested on a LilyGo TTGO Meshtastic 1.2 ESP32 LoRa.
 It has a embedded SSD1306 0.96’’ monochrome OLED display.
@@ -18,6 +19,7 @@ You must also install the Adafruit_SSD1306 library to compile it!
 #include <Wire.h>
 #include <Adafruit_SSD1306.h>
 #include <QRCodeGFX.h>
+#include <QRCodeDisplayList.h>
 
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
@@ -29,6 +31,7 @@ You must also install the Adafruit_SSD1306 library to compile it!
 Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, RESET_PIN);
 
 QRCodeGFX qrcode(display);
+QRCodeDisplayList displayList;
 
 #define ROTATION_INTERVAL 3000 // miliseconds
 unsigned long previousRotationInstant;
@@ -55,10 +58,12 @@ void setup() {
   // Generate QR Code data
   // It's an old but awesome Brazilian song. =)
   qrcode.generateData("https://youtu.be/0dU4mLOHGIQ");
-  
-  // Draw generated QR Code and don't release its data from memory
-  // This way we can keep drawing it again and again without having to generate it
-  qrcode.draw(0, 0, false);
+
+  // Turn the data into a list of rectangles (the data itself is released)
+  // This way we can keep drawing it again and again, with any rotation, without having to generate it
+  // You could also keep the data with qrcode.draw(0, 0, false), but each redraw would go module by module
+  qrcode.buildDisplayList(displayList);
+  qrcode.draw(displayList, 0, 0);
 
   // Write song title and artist
   display.setTextColor(WHITE);
@@ -97,7 +102,7 @@ void loop() {
     }
     qrcode.setRotation(rotationAngle);
     
-    qrcode.draw(0, 0, false);
+    qrcode.draw(displayList, 0, 0);
 
     display.display();
   }
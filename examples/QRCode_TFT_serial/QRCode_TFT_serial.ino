@@ -39,35 +39,40 @@ void setup() {
   display.print("Serial Monitor...");
 }
 
+// Longest text accepted from Serial Monitor
+// The payload is read straight into the QR Code buffer, so this also sets its size
+#define MAX_TEXT_LENGTH 128
+
 void loop() {
   // Draw a big QR Code if user sends a text via Serial
   if (Serial.available()) {
-    // Get text sent by user
-    String text = Serial.readStringUntil('\n');
-    Serial.println(text);
+    // Read the text sent by user and generate the QR Code data
+    // No String is built: the bytes go straight from Serial into the QR Code buffer
+    bool success = qrcode.generateFrom(Serial, '\n', MAX_TEXT_LENGTH);
 
     // Erase previous QR Code
     display.fillScreen(TFT_BLACK);
 
+    if (!success) {
+      display.setTextSize(2);
+      display.setTextColor(TFT_WHITE);
+      display.setCursor(37, 150);
+      display.print("TEXT TOO LONG!");
+      return;
+    }
+
     // Find the biggest scale that fits the screen
-    int version = qrcode.getGenerator().getMinVersion(text);
-    int baseSideLength = (version * 4 + 17 + 6);
+    int baseSideLength = qrcode.setScale(1).getSideLength();
     int scale = display.width() / baseSideLength;
-    int finalSideLength = baseSideLength * scale;
     
     qrcode.setScale(scale);
 
     // Center the qr code
+    int finalSideLength = qrcode.getSideLength();
     int x = (display.width() - finalSideLength) / 2;
     int y = (display.height() - finalSideLength) / 2;
 
     // Draw it!
-    bool success = qrcode.draw(text, x, y);
-    if (!success) {
-      display.setTextSize(2);
-      display.setTextColor(TFT_WHITE);
-      display.setCursor(37, 150);
-      display.print("TEXT TOO LONG!");
-    }
+    qrcode.draw(x, y);
   }
 }
\ No newline at end of file
@@ -0,0 +1,131 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+This example measures how batch encoding scales with the number of
+threads. It encodes a few thousand payloads of different lengths
+(versions 1 to 10) with a thread pool of 1 worker, then 2, and so on
+up to one worker per hardware thread.
+For each pool size it prints on Serial Monitor:
+- the best time of a few runs
+- the throughput, in QR Codes per second
+- the speedup over 1 worker
+- whether the results match the 1 worker run
+No display is needed.
+
+It is meant for hosted builds (a computer): the texts and outputs
+take about 2.5 MB of RAM. On an ESP32, lower PAYLOAD_COUNT to 64 or so.
+Set MAX_WORKERS to sweep further than the hardware threads
+(e.g. to see what oversubscription costs).
+
+*************************************************/
+
+
+#include <QRCodeGFX.h>
+
+#ifndef QRCODE_THREAD_POOL_ENABLED
+#error "This example needs threads (a computer or an ESP32)"
+#endif
+
+#define PAYLOAD_COUNT 4096
+#define MAX_VERSION 10
+#define MAX_WORKERS 0 // 0 stops at one worker per hardware thread
+#define RUNS 3
+#define MAX_TEXT_LENGTH 200 // fits version 10 with Medium error correction
+
+typedef uint8_t QRCodeSlot[qrcodegen_BUFFER_LEN_FOR_VERSION(MAX_VERSION)];
+
+QRCodeGenerator generator;
+
+char texts[PAYLOAD_COUNT][MAX_TEXT_LENGTH + 1];
+QRCodeBatchItem items[PAYLOAD_COUNT];
+QRCodeSlot *referenceOutput;
+QRCodeSlot *output;
+
+// Best time of a few runs, so a busy moment of the system doesn't count
+unsigned long encode(QRCodeSlot *slots, QRCodeExecutor *executor) {
+  unsigned long best = 0;
+  for (int run = 0; run < RUNS; run++) {
+    for (int i = 0; i < PAYLOAD_COUNT; i++) {
+      items[i].text = texts[i];
+      items[i].qrcode = slots[i];
+      items[i].size = sizeof(slots[i]);
+    }
+
+    unsigned long start = micros();
+    bool success = generator.generateBatch(items, PAYLOAD_COUNT, executor);
+    unsigned long elapsed = micros() - start;
+
+    if (!success) {
+      Serial.println("Some payloads could not be encoded!");
+    }
+    if (run == 0 || elapsed < best) {
+      best = elapsed;
+    }
+  }
+  return best;
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  generator.setVersionRange(1, MAX_VERSION)
+           .setErrorCorrectionLevel(QRCodeECCLevel::Medium);
+
+  // Lengths from a short ID to a long URL, so the versions (and costs) vary like real labels
+  for (int i = 0; i < PAYLOAD_COUNT; i++) {
+    int length = 32 + (i * 7919) % (MAX_TEXT_LENGTH - 31);
+    snprintf(texts[i], sizeof(texts[i]), "https://example.com/item/%05d?", i);
+    for (int j = strlen(texts[i]); j < length; j++) {
+      texts[i][j] = 'a' + (i + j) % 26;
+    }
+    texts[i][length] = '\0';
+  }
+
+  referenceOutput = (QRCodeSlot *)malloc(sizeof(QRCodeSlot) * PAYLOAD_COUNT);
+  output = (QRCodeSlot *)malloc(sizeof(QRCodeSlot) * PAYLOAD_COUNT);
+  if (referenceOutput == NULL || output == NULL) {
+    Serial.println("Not enough memory, lower PAYLOAD_COUNT");
+    return;
+  }
+
+  uint8_t maxWorkers = MAX_WORKERS;
+  if (maxWorkers == 0) {
+    QRCodeThreadPool hardwarePool; // one worker per hardware thread
+    maxWorkers = hardwarePool.getWorkerCount();
+  }
+
+  Serial.print(PAYLOAD_COUNT);
+  Serial.println(" payloads, versions 1 to 10");
+  Serial.println("workers  time (us)  QR Codes/s  speedup");
+
+  unsigned long serialTime = 0;
+  for (uint8_t workers = 1; workers <= maxWorkers; workers++) {
+    QRCodeThreadPool pool(workers);
+    unsigned long time = encode(workers == 1 ? referenceOutput : output, &pool);
+    if (workers == 1) {
+      serialTime = time;
+    }
+
+    Serial.print(workers);
+    Serial.print("        ");
+    Serial.print(time);
+    Serial.print("     ");
+    Serial.print((unsigned long)((float)PAYLOAD_COUNT * 1000000 / time));
+    Serial.print("      ");
+    Serial.print((float)serialTime / time);
+    // The results never depend on the number of workers
+    if (workers > 1 && memcmp(referenceOutput, output, sizeof(QRCodeSlot) * PAYLOAD_COUNT) != 0) {
+      Serial.print("  results differ!");
+    }
+    Serial.println();
+  }
+
+  free(referenceOutput);
+  free(output);
+}
+
+void loop() {
+}
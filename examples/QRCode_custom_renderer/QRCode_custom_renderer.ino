@@ -0,0 +1,80 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+This example will print a QR Code in the Serial Monitor, without any display.
+It shows how to visit the modules yourself, for renderers that don't use
+Adafruit_GFX (LED matrices, NeoPixel panels, thermal printers...).
+
+It runs on any board. Open the Serial Monitor at 115200 baud,
+preferably with a font where the block characters are square.
+
+*************************************************/
+
+#include <QRCodeGenerator.h>
+#include <QRCodeModules.h>
+
+QRCodeGenerator generator;
+
+uint16_t runCount = 0;
+
+// The terminal has a dark background, so light modules are printed as blocks
+// Each module takes 2 characters, so it looks square
+void printModule(bool dark) {
+  Serial.print(dark ? "  " : "██");
+}
+
+// Light modules around the QR Code, 3 modules wide
+void printQuietRows(uint8_t size) {
+  for (uint8_t y = 0; y < 3; y++) {
+    for (uint8_t x = 0; x < size + 6; x++) {
+      printModule(false);
+    }
+    Serial.println();
+  }
+}
+
+// Called once per row, with the modules packed 8 per byte (leftmost module in the most significant bit)
+void printRow(uint8_t y, const uint8_t *modules, uint8_t size, void *context) {
+  for (uint8_t x = 0; x < 3; x++) {
+    printModule(false);
+  }
+  for (uint8_t x = 0; x < size; x++) {
+    printModule(modules[x / 8] & (0x80 >> (x % 8)));
+  }
+  for (uint8_t x = 0; x < 3; x++) {
+    printModule(false);
+  }
+  Serial.println();
+}
+
+// Called once per horizontal run of dark modules: a single line of LEDs or printer dots
+void countRun(uint8_t y, uint8_t x, uint8_t length, void *context) {
+  runCount++;
+}
+
+void setup() {
+  Serial.begin(115200); delay(1000);
+
+  uint8_t *data = generator.generateData("https://github.com/wallysalami/QRCodeGFX");
+  if (data == NULL) {
+    Serial.println("Not enough memory");
+    return;
+  }
+
+  printQuietRows(data[0]); // the first byte of the data is the size
+  QRCodeModules::forEachRow(data, printRow);
+  printQuietRows(data[0]);
+
+  // A panel mounted sideways can get the rows already rotated
+  QRCodeModules::forEachDarkRun(data, countRun, NULL, QRCodeRotation::R90);
+  Serial.print("Dark runs: ");
+  Serial.println(runCount);
+
+  free(data);
+}
+
+void loop() {
+}
@@ -7,6 +7,8 @@ https://github.com/wallysalami/QRCodeGFX
 This example simulates a music player screen.
 It has a QR Code for the video clip link.
 It combines the QR Code with other drawing methods from Adafruit_GFX.
+The QR Code is generated a little at a time in loop(), so the time slider
+keeps running while it is encoded.
 
 This program was tested on a ESP32 S3 with a WeAct 2.9'' Black-White E-Paper Display.
 It should work with Waveshare E-Paper Display as well.
@@ -64,10 +66,11 @@ void setup() {
   display.setCursor(10, 82);
   display.print("Dangerous - 1991");
 
-  // Draw QR Code for video link
+  // Start generating the QR Code for video link
+  // It is drawn in loop() once ready
   // The face transitions at the end are still incredible to watch.
   qrcode.setScale(3);
-  qrcode.draw("https://youtu.be/F2AitTPI5U0", 202, 0);
+  qrcode.beginGenerate("https://youtu.be/F2AitTPI5U0");
 
   // Time slider
   updateTimeSlider();
@@ -80,6 +83,12 @@ void setup() {
 }
 
 void loop() {
+  // Encode for at most about 2 ms per loop, then draw the QR Code when it is done
+  if (qrcode.isGenerating() && qrcode.step(2000) == 100) {
+    qrcode.draw(202, 0);
+    display.display(true);
+  }
+
   if (millis() > previousInstant + 1000 && currentTime < totalTime) {
     // some e-paper displays might take more than 1 second to update
     // WeAct displays take about 700ms
@@ -0,0 +1,117 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+This example measures how much work QRCodeGFX sends to a display,
+without any display. It draws on a QRCodeRecordingGFX, which counts
+every call and estimates the time a real driver would take.
+It prints one line per version, scale and rotation on Serial Monitor,
+for three driver models: ILI9341 (SPI TFT), SSD1306 (I2C OLED)
+and GxEPD2 (SPI e-paper).
+
+The modelled times are estimates, useful to compare drawing strategies,
+not to predict exact timings on a given board.
+
+It also checks that incremental drawing gives the same pixels as draw(),
+for every rotation.
+
+It needs about 70 KB of RAM, so it won't fit on an Arduino Uno.
+So far it has only been run on a hosted build (a computer).
+
+*************************************************/
+
+
+#include <QRCodeGFX.h>
+#include <QRCodeRecordingGFX.h>
+
+// Large enough for version 40 at scale 4; no framebuffer, only counters
+#define BENCHMARK_SIZE 1024
+
+// Small displays that keep their pixels, for comparisons
+#define CHECK_SIZE 128
+
+const uint8_t versions[] = {1, 5, 10, 20, 40};
+const uint8_t scales[] = {1, 2, 4};
+const QRCodeDisplayModel *models[] = {
+  &QRCodeRecordingGFX::ILI9341,
+  &QRCodeRecordingGFX::SSD1306,
+  &QRCodeRecordingGFX::GxEPD2
+};
+
+void benchmark(const QRCodeDisplayModel &model) {
+  QRCodeRecordingGFX display(BENCHMARK_SIZE, BENCHMARK_SIZE, model, false);
+  QRCodeGFX qrcode(display);
+
+  Serial.print("\n");
+  Serial.println(model.name);
+  Serial.println("version scale rotation drawPixel fillRect  pixels  bytes transactions micros");
+
+  for (uint8_t version : versions) {
+    qrcode.getGenerator().setVersion(version);
+    if (!qrcode.generateData("QRCodeGFX")) {
+      Serial.println("Generation failed (not enough memory?)");
+      continue;
+    }
+
+    for (uint8_t scale : scales) {
+      for (uint8_t rotation = 0; rotation < 4; rotation++) {
+        qrcode.setScale(scale).setRotation((QRCodeRotation)rotation);
+
+        display.resetCounters();
+        qrcode.draw(0, 0, false);
+        display.flush(); // display() on buffered drivers
+
+        const QRCodeRenderCounters &counters = display.getCounters();
+        char line[100];
+        snprintf(line, sizeof(line), "%7u %5u %8u %9lu %8lu %7lu %6lu %12lu %6lu",
+                 version, scale, rotation * 90,
+                 (unsigned long)counters.drawPixelCalls, (unsigned long)counters.fillRectCalls,
+                 (unsigned long)counters.pixels, (unsigned long)counters.busBytes,
+                 (unsigned long)counters.transactions, (unsigned long)display.getModelledMicros());
+        Serial.println(line);
+      }
+    }
+
+    qrcode.releaseData();
+  }
+}
+
+void checkIncrementalDrawing() {
+  QRCodeRecordingGFX expected(CHECK_SIZE, CHECK_SIZE);
+  QRCodeRecordingGFX actual(CHECK_SIZE, CHECK_SIZE);
+  QRCodeGFX expectedQRCode(expected);
+  QRCodeGFX actualQRCode(actual);
+
+  Serial.print("\nIncremental drawing: ");
+  for (uint8_t rotation = 0; rotation < 4; rotation++) {
+    expectedQRCode.setScale(2).setRotation((QRCodeRotation)rotation);
+    actualQRCode.setScale(2).setRotation((QRCodeRotation)rotation);
+
+    expectedQRCode.draw("Same pixels?", 3, 5);
+
+    actualQRCode.generateData("Same pixels?");
+    actualQRCode.beginDraw(3, 5);
+    while (!actualQRCode.drawRows(3));
+
+    if (!expected.samePixels(actual)) {
+      Serial.print("different pixels at rotation ");
+      Serial.println(rotation * 90);
+      return;
+    }
+  }
+  Serial.println("same pixels");
+}
+
+void setup() {
+  Serial.begin(115200);
+
+  for (const QRCodeDisplayModel *model : models) {
+    benchmark(*model);
+  }
+  checkIncrementalDrawing();
+}
+
+void loop() {
+}
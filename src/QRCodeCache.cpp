@@ -0,0 +1,187 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeCache.h"
+
+// Constructor
+
+QRCodeCache::QRCodeCache(size_t budget): budget(budget) {
+}
+
+// Destructor
+
+QRCodeCache::~QRCodeCache() {
+  clear();
+}
+
+// Lookup and insertion
+
+uint32_t QRCodeCache::hash(const uint8_t *payload, size_t length, bool payloadInFlash) {
+  uint32_t result = 2166136261UL;
+  for (size_t i = 0; i < length; i++) {
+    result ^= payloadInFlash ? pgm_read_byte(payload + i) : payload[i];
+    result *= 16777619UL;
+  }
+  return result;
+}
+
+const uint8_t* QRCodeCache::find(const QRCodeCacheKey &key, const uint8_t *payload, bool payloadInFlash) {
+  for (Entry *entry = first; entry != NULL; entry = entry->next) {
+    if (equalKeys(entry->key, key)
+        && equalPayloads(getPayload(entry), payload, key.length, payloadInFlash)) {
+      // Move it to the front, it is now the most recently used
+      unlink(entry);
+      pushFront(entry);
+      hits++;
+      return getQRCode(entry);
+    }
+  }
+
+  misses++;
+  return NULL;
+}
+
+uint8_t* QRCodeCache::add(const QRCodeCacheKey &key, const uint8_t *payload, bool payloadInFlash, uint16_t qrcodeLength) {
+  size_t size = getEntrySize(qrcodeLength, key.length);
+  if (size > budget) {
+    return NULL; // would never fit
+  }
+
+  while (usedBytes + size > budget) {
+    removeEntry(last);
+  }
+
+  Entry *entry = (Entry *)malloc(size);
+  if (entry == NULL) {
+    return NULL; // not enough memory, just don't cache it
+  }
+
+  entry->key = key;
+  entry->qrcodeLength = qrcodeLength;
+  uint8_t *cachedPayload = getPayload(entry);
+  for (uint16_t i = 0; i < key.length; i++) {
+    cachedPayload[i] = payloadInFlash ? pgm_read_byte(payload + i) : payload[i];
+  }
+
+  pushFront(entry);
+  usedBytes += size;
+  entryCount++;
+
+  return getQRCode(entry);
+}
+
+void QRCodeCache::remove(uint8_t *qrcode) {
+  if (qrcode != NULL) {
+    removeEntry((Entry *)(qrcode - sizeof(Entry)));
+  }
+}
+
+void QRCodeCache::clear() {
+  while (last != NULL) {
+    removeEntry(last);
+  }
+}
+
+// Getters
+
+size_t QRCodeCache::getBudget() {
+  return budget;
+}
+
+size_t QRCodeCache::getUsedBytes() {
+  return usedBytes;
+}
+
+uint16_t QRCodeCache::getEntryCount() {
+  return entryCount;
+}
+
+uint32_t QRCodeCache::getHits() {
+  return hits;
+}
+
+uint32_t QRCodeCache::getMisses() {
+  return misses;
+}
+
+void QRCodeCache::resetCounters() {
+  hits = 0;
+  misses = 0;
+}
+
+// Private helpers
+
+uint8_t* QRCodeCache::getQRCode(Entry *entry) {
+  return (uint8_t *)entry + sizeof(Entry);
+}
+
+uint8_t* QRCodeCache::getPayload(Entry *entry) {
+  return getQRCode(entry) + entry->qrcodeLength;
+}
+
+size_t QRCodeCache::getEntrySize(uint16_t qrcodeLength, uint16_t payloadLength) {
+  return sizeof(Entry) + qrcodeLength + payloadLength;
+}
+
+bool QRCodeCache::equalKeys(const QRCodeCacheKey &a, const QRCodeCacheKey &b) {
+  return a.hash == b.hash
+      && a.length == b.length
+      && a.binary == b.binary
+      && a.errorCorrectionLevel == b.errorCorrectionLevel
+      && a.minVersion == b.minVersion
+      && a.maxVersion == b.maxVersion
+      && a.mask == b.mask;
+}
+
+bool QRCodeCache::equalPayloads(const uint8_t *cached, const uint8_t *payload, size_t length, bool payloadInFlash) {
+  if (!payloadInFlash) {
+    return memcmp(cached, payload, length) == 0;
+  }
+
+  for (size_t i = 0; i < length; i++) {
+    if (cached[i] != pgm_read_byte(payload + i)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+void QRCodeCache::unlink(Entry *entry) {
+  if (entry->previous != NULL) {
+    entry->previous->next = entry->next;
+  }
+  else {
+    first = entry->next;
+  }
+
+  if (entry->next != NULL) {
+    entry->next->previous = entry->previous;
+  }
+  else {
+    last = entry->previous;
+  }
+}
+
+void QRCodeCache::pushFront(Entry *entry) {
+  entry->previous = NULL;
+  entry->next = first;
+  if (first != NULL) {
+    first->previous = entry;
+  }
+  first = entry;
+  if (last == NULL) {
+    last = entry;
+  }
+}
+
+void QRCodeCache::removeEntry(Entry *entry) {
+  unlink(entry);
+  usedBytes -= getEntrySize(entry->qrcodeLength, entry->key.length);
+  entryCount--;
+  free(entry);
+}
@@ -0,0 +1,86 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+
+// Everything that determines the symbol generated for a payload
+struct QRCodeCacheKey {
+  uint32_t hash;        // FNV-1a hash of the payload bytes
+  uint16_t length;      // payload length in bytes
+  bool binary;          // binary payloads are always encoded in byte mode, text may use other modes
+  uint8_t errorCorrectionLevel;
+  uint8_t minVersion;
+  uint8_t maxVersion;
+  int8_t mask;
+};
+
+// Keeps recently generated QR Codes in memory, so showing them again skips encoding
+// Entries are allocated on the heap and the least recently used ones are evicted to respect the byte budget
+// Each entry costs its symbol (qrcodegen_BUFFER_LEN_FOR_VERSION bytes), its payload and a small header
+// Attach it to a generator with QRCodeGenerator::setCache()
+class QRCodeCache {
+private:
+  struct Entry {
+    Entry *previous;  // more recently used
+    Entry *next;      // less recently used
+    QRCodeCacheKey key;
+    uint16_t qrcodeLength;
+    // Followed by qrcodeLength bytes of symbol and key.length bytes of payload
+  };
+
+  size_t budget;
+  size_t usedBytes = 0;
+  uint16_t entryCount = 0;
+  Entry *first = NULL; // most recently used
+  Entry *last = NULL;  // least recently used
+  uint32_t hits = 0;
+  uint32_t misses = 0;
+
+  static uint8_t* getQRCode(Entry *entry);
+  static uint8_t* getPayload(Entry *entry);
+  static size_t getEntrySize(uint16_t qrcodeLength, uint16_t payloadLength);
+  static bool equalKeys(const QRCodeCacheKey &a, const QRCodeCacheKey &b);
+  static bool equalPayloads(const uint8_t *cached, const uint8_t *payload, size_t length, bool payloadInFlash);
+  void unlink(Entry *entry);
+  void pushFront(Entry *entry);
+  void removeEntry(Entry *entry);
+
+public:
+  // Constructor
+  // budget is the maximum number of bytes used by all entries together
+  QRCodeCache(size_t budget);
+
+  // Destructor
+  ~QRCodeCache();
+
+  // Builds the hash part of a key (payloadInFlash is for strings stored with F() or PROGMEM)
+  static uint32_t hash(const uint8_t *payload, size_t length, bool payloadInFlash = false);
+
+  // Returns the cached symbol for the key and payload, or NULL on a miss
+  // The pointer is valid until the cache is changed again
+  const uint8_t* find(const QRCodeCacheKey &key, const uint8_t *payload, bool payloadInFlash = false);
+
+  // Adds an entry for the payload, evicting the least recently used ones to make room
+  // Returns where the symbol (qrcodeLength bytes) must be copied, or NULL if it can't be cached
+  uint8_t* add(const QRCodeCacheKey &key, const uint8_t *payload, bool payloadInFlash, uint16_t qrcodeLength);
+
+  // Removes the entry whose symbol storage was returned by add (e.g. when encoding fails)
+  void remove(uint8_t *qrcode);
+
+  void clear();
+
+  // Getters
+  size_t getBudget();
+  size_t getUsedBytes();
+  uint16_t getEntryCount();
+  uint32_t getHits();
+  uint32_t getMisses();
+  void resetCounters();
+};
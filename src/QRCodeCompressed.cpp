@@ -0,0 +1,343 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeCompressed.h"
+#include "qrcodegen.h"
+
+// The function patterns of a QR Code, as drawn by qrcodegen
+// They depend only on the version, plus the format information (error correction level and mask)
+class QRCodeFunctionPatterns {
+private:
+  uint8_t version;
+  uint8_t size;
+  uint16_t formatBits;
+  uint32_t versionBits;
+  uint8_t alignmentPositions[7];
+  uint8_t alignmentCount = 0;
+
+  static uint8_t getDistance(int dx, int dy) {
+    dx = dx < 0 ? -dx : dx;
+    dy = dy < 0 ? -dy : dy;
+    return dx > dy ? dx : dy;
+  }
+
+  static void markSpan(uint8_t row[], uint8_t start, uint8_t end) {
+    for (uint8_t x = start; x < end; x++) {
+      row[x >> 3] |= 0x80 >> (x & 7);
+    }
+  }
+
+public:
+  // format is the error correction level (in the QR Code's own order) and the mask, without error correction
+  QRCodeFunctionPatterns(uint8_t version, uint8_t format) : version(version), size(version * 4 + 17) {
+    uint16_t remainder = format;
+    for (uint8_t i = 0; i < 10; i++) {
+      remainder = (remainder << 1) ^ ((remainder >> 9) * 0x537);
+    }
+    formatBits = (format << 10 | remainder) ^ 0x5412;
+
+    uint32_t versionRemainder = version;
+    for (uint8_t i = 0; i < 12; i++) {
+      versionRemainder = (versionRemainder << 1) ^ ((versionRemainder >> 11) * 0x1F25);
+    }
+    versionBits = (uint32_t)version << 12 | versionRemainder;
+
+    if (version > 1) {
+      alignmentCount = version / 7 + 2;
+      uint8_t step = (version * 8 + alignmentCount * 3 + 5) / (alignmentCount * 4 - 4) * 2;
+      uint8_t position = version * 4 + 10;
+      for (uint8_t i = alignmentCount - 1; i >= 1; i--, position -= step) {
+        alignmentPositions[i] = position;
+      }
+      alignmentPositions[0] = 6;
+    }
+  }
+
+  uint8_t getSize() {
+    return size;
+  }
+
+  // Number of modules that are not function modules, counted like qrcodegen (including the remainder bits)
+  static uint16_t getDataModules(uint8_t version) {
+    uint32_t modules = (16UL * version + 128) * version + 64;
+    if (version >= 2) {
+      uint8_t alignmentCount = version / 7 + 2;
+      modules -= (25UL * alignmentCount - 10) * alignmentCount - 55;
+      if (version >= 7) {
+        modules -= 36;
+      }
+    }
+    return modules;
+  }
+
+  // Marks the function modules of row y, leftmost module in the most significant bit of row[0]
+  // The row is built from a few spans, so data modules can then be told apart with a bit test
+  void getFunctionRow(uint8_t y, uint8_t row[]) {
+    memset(row, 0, (size + 7) / 8);
+    if (y == 6) {
+      markSpan(row, 0, size);
+      return;
+    }
+    markSpan(row, 6, 7);
+    if (y < 9) {
+      markSpan(row, 0, 9);
+      markSpan(row, size - 8, size);
+    }
+    else if (y >= size - 8) {
+      markSpan(row, 0, 9);
+    }
+    if (version >= 7) {
+      if (y < 6) {
+        markSpan(row, size - 11, size - 8);
+      }
+      else if (y >= size - 11 && y < size - 8) {
+        markSpan(row, 0, 6);
+      }
+    }
+    for (uint8_t j = 0; j < alignmentCount; j++) {
+      if (getDistance(y - alignmentPositions[j], 0) > 2) {
+        continue;
+      }
+      for (uint8_t i = 0; i < alignmentCount; i++) {
+        if (!((i == 0 && j == 0) || (i == 0 && j == alignmentCount - 1) || (i == alignmentCount - 1 && j == 0))) {
+          markSpan(row, alignmentPositions[i] - 2, alignmentPositions[i] + 3);
+        }
+      }
+    }
+  }
+
+  // Returns true if the module belongs to a function pattern, and its color in dark
+  // This is the slow part, only call it for modules marked by getFunctionRow
+  bool isFunction(uint8_t x, uint8_t y, bool &dark) {
+    // Finder pattern with its separator, format information and timing crossing at the top left
+    if (x < 9 && y < 9) {
+      if ((x == 8 || y == 8) && x != 6 && y != 6) {
+        uint8_t bit = x == 8 ? (y < 6 ? y : y - 1) : (x == 7 ? 8 : 14 - x);
+        dark = (formatBits >> bit) & 1;
+      }
+      else {
+        uint8_t distance = getDistance(x - 3, y - 3);
+        dark = distance != 2 && distance != 4;
+      }
+      return true;
+    }
+    // Top right finder and second copy of the format information below it
+    if (x >= size - 8 && y < 9) {
+      if (y == 8) {
+        dark = (formatBits >> (size - 1 - x)) & 1;
+      }
+      else {
+        uint8_t distance = getDistance(x - (size - 4), y - 3);
+        dark = distance != 2 && distance != 4;
+      }
+      return true;
+    }
+    // Bottom left finder and the rest of the second copy, including the module that is always dark
+    if (x < 9 && y >= size - 8) {
+      if (x == 8) {
+        dark = y == size - 8 || ((formatBits >> (y - size + 15)) & 1);
+      }
+      else {
+        uint8_t distance = getDistance(x - 3, y - (size - 4));
+        dark = distance != 2 && distance != 4;
+      }
+      return true;
+    }
+    // Version information, two copies of 6x3 modules
+    if (version >= 7) {
+      if (x >= size - 11 && x < size - 8 && y < 6) {
+        dark = (versionBits >> (y * 3 + x - (size - 11))) & 1;
+        return true;
+      }
+      if (y >= size - 11 && y < size - 8 && x < 6) {
+        dark = (versionBits >> (x * 3 + y - (size - 11))) & 1;
+        return true;
+      }
+    }
+    // Alignment patterns, except on the finder corners
+    for (uint8_t i = 0; i < alignmentCount; i++) {
+      if (getDistance(x - alignmentPositions[i], 0) > 2) {
+        continue;
+      }
+      for (uint8_t j = 0; j < alignmentCount; j++) {
+        if ((i == 0 && j == 0) || (i == 0 && j == alignmentCount - 1) || (i == alignmentCount - 1 && j == 0)) {
+          continue;
+        }
+        uint8_t distance = getDistance(x - alignmentPositions[i], y - alignmentPositions[j]);
+        if (distance <= 2) {
+          dark = distance != 1;
+          return true;
+        }
+      }
+    }
+    // Timing patterns
+    if (x == 6 || y == 6) {
+      dark = (x + y) % 2 == 0;
+      return true;
+    }
+    return false;
+  }
+};
+
+// Constructor
+
+QRCodeCompressed::QRCodeCompressed() {
+}
+
+// Destructor
+
+QRCodeCompressed::~QRCodeCompressed() {
+  clear();
+}
+
+// Compression methods
+
+bool QRCodeCompressed::compress(const uint8_t *qrcode) {
+  clear();
+  if (qrcode == NULL || qrcode[0] < 21 || qrcode[0] > 177 || (qrcode[0] - 17) % 4 != 0) {
+    return false; // error: not QR Code data
+  }
+  uint8_t version = (qrcode[0] - 17) / 4;
+
+  // Format information from its first copy, without its error correction bits
+  uint16_t formatBits = 0;
+  for (uint8_t i = 0; i < 15; i++) {
+    bool bit = i < 6 ? qrcodegen_getModule(qrcode, 8, i)
+             : i < 8 ? qrcodegen_getModule(qrcode, 8, i + 1)
+             : i == 8 ? qrcodegen_getModule(qrcode, 7, 8)
+             : qrcodegen_getModule(qrcode, 14 - i, 8);
+    formatBits |= (uint16_t)bit << i;
+  }
+  uint8_t format = (formatBits ^ 0x5412) >> 10;
+
+  size_t length = getCompressedLength(version);
+  uint8_t *compressed = (uint8_t *)malloc(length);
+  if (compressed == NULL) {
+    return false; // error: not enough memory
+  }
+  memset(compressed, 0, length);
+  compressed[0] = version;
+  compressed[1] = format;
+
+  // Data modules in row order, least significant bit first like qrcodegen, checking the function modules on the way
+  QRCodeFunctionPatterns patterns(version, format);
+  uint8_t size = patterns.getSize();
+  uint8_t functionRow[(qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8];
+  uint16_t bit = 0;
+  for (uint8_t y = 0; y < size; y++) {
+    patterns.getFunctionRow(y, functionRow);
+    for (uint8_t x = 0; x < size; x++) {
+      bool dark = qrcodegen_getModule(qrcode, x, y);
+      bool functionDark;
+      if ((functionRow[x >> 3] & (0x80 >> (x & 7))) != 0 && patterns.isFunction(x, y, functionDark)) {
+        if (dark != functionDark) {
+          free(compressed);
+          return false; // error: not a standard QR Code, it can't be rebuilt
+        }
+        continue;
+      }
+      if (dark) {
+        compressed[2 + (bit >> 3)] |= 1 << (bit & 7);
+      }
+      bit++;
+    }
+  }
+  if (bit != QRCodeFunctionPatterns::getDataModules(version)) {
+    free(compressed);
+    return false;
+  }
+
+  data = compressed;
+  return true;
+}
+
+bool QRCodeCompressed::decompress(uint8_t *qrcode) const {
+  if (data == NULL) {
+    return false;
+  }
+
+  QRCodeFunctionPatterns patterns(data[0], data[1]);
+  uint8_t size = patterns.getSize();
+  memset(qrcode, 0, qrcodegen_BUFFER_LEN_FOR_VERSION(data[0]));
+  qrcode[0] = size;
+  uint8_t functionRow[(qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8];
+  uint16_t bit = 0;
+  for (uint8_t y = 0; y < size; y++) {
+    patterns.getFunctionRow(y, functionRow);
+    for (uint8_t x = 0; x < size; x++) {
+      bool dark;
+      if ((functionRow[x >> 3] & (0x80 >> (x & 7))) == 0 || !patterns.isFunction(x, y, dark)) {
+        dark = (data[2 + (bit >> 3)] >> (bit & 7)) & 1;
+        bit++;
+      }
+      if (dark) {
+        // Same bit layout as qrcodegen_getModule
+        int index = y * size + x;
+        qrcode[(index >> 3) + 1] |= 1 << (index & 7);
+      }
+    }
+  }
+  return true;
+}
+
+bool QRCodeCompressed::writeRows(QRCodeRowSink &sink) const {
+  if (data == NULL) {
+    return false;
+  }
+
+  QRCodeFunctionPatterns patterns(data[0], data[1]);
+  uint8_t size = patterns.getSize();
+  uint8_t modules[(qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8];
+  uint8_t functionRow[(qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8];
+  uint16_t bit = 0;
+  sink.begin(size);
+  for (uint8_t y = 0; y < size; y++) {
+    memset(modules, 0, sizeof(modules));
+    patterns.getFunctionRow(y, functionRow);
+    for (uint8_t x = 0; x < size; x++) {
+      bool dark;
+      if ((functionRow[x >> 3] & (0x80 >> (x & 7))) == 0 || !patterns.isFunction(x, y, dark)) {
+        dark = (data[2 + (bit >> 3)] >> (bit & 7)) & 1;
+        bit++;
+      }
+      if (dark) {
+        modules[x >> 3] |= 0x80 >> (x & 7);
+      }
+    }
+    sink.writeRow(y, modules, size);
+  }
+  sink.end();
+  return true;
+}
+
+void QRCodeCompressed::clear() {
+  free(data);
+  data = NULL;
+}
+
+// Getters
+
+bool QRCodeCompressed::isEmpty() const {
+  return data == NULL;
+}
+
+uint8_t QRCodeCompressed::getVersion() const {
+  return data == NULL ? 0 : data[0];
+}
+
+uint8_t QRCodeCompressed::getSize() const {
+  return data == NULL ? 0 : data[0] * 4 + 17;
+}
+
+size_t QRCodeCompressed::getBytes() const {
+  return data == NULL ? 0 : getCompressedLength(data[0]);
+}
+
+size_t QRCodeCompressed::getCompressedLength(uint8_t version) {
+  return 2 + (QRCodeFunctionPatterns::getDataModules(version) + 7) / 8;
+}
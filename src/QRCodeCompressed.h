@@ -0,0 +1,60 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "QRCodeRowSink.h"
+
+// A QR Code stored without its function patterns (finders, separators, timing, alignment, format and version
+// information), which are rebuilt from the version, the error correction level and the mask when it is drawn
+// Only the data modules are kept, 1 bit each in row order, so rows are read back one after the other without
+// rebuilding the whole grid
+// The saving is the share of function modules: about half the QR Code data for version 1, 40% for version 2,
+// 25% for version 5 and 15% for version 10. The data modules themselves can't be compressed further,
+// since the mask makes them look random
+//   QRCodeCompressed compressed;
+//   qrcode.generateData(text);
+//   qrcode.compressData(compressed);
+//   qrcode.draw(compressed, x, y);
+class QRCodeCompressed {
+private:
+  uint8_t *data = NULL;  // version, format, then the data modules
+
+public:
+  // Constructor
+  QRCodeCompressed();
+
+  // Destructor
+  ~QRCodeCompressed();
+
+  // Compressed QR Codes own their data, so they can't be copied
+  QRCodeCompressed(const QRCodeCompressed&) = delete;
+  QRCodeCompressed& operator=(const QRCodeCompressed&) = delete;
+
+  // Compresses QR Code data (e.g. returned by QRCodeGenerator::generateData), replacing any previous one
+  // Returns false if there is not enough memory, or if the function patterns are not the standard ones
+  bool compress(const uint8_t *qrcode);
+
+  // Rebuilds the full QR Code data, qrcodegen_BUFFER_LEN_FOR_VERSION(getVersion()) bytes
+  bool decompress(uint8_t *qrcode) const;
+
+  // Sends the modules to sink row by row, like QRCodeGenerator::generateRows
+  bool writeRows(QRCodeRowSink &sink) const;
+
+  void clear();
+
+  // Getters
+  bool isEmpty() const;
+  uint8_t getVersion() const;  // 0 if empty
+  uint8_t getSize() const;     // modules per side, 0 if empty
+  size_t getBytes() const;
+
+  // Bytes taken by a compressed QR Code of the given version
+  static size_t getCompressedLength(uint8_t version);
+};
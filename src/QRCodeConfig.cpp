@@ -0,0 +1,379 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeConfig.h"
+
+// Encode context
+
+QRCodeEncodeContext::QRCodeEncodeContext() {
+}
+
+QRCodeEncodeContext::QRCodeEncodeContext(uint8_t *qrcodeBuffer, uint8_t *tempBuffer, uint16_t size) {
+  this->qrcodeBuffer = qrcodeBuffer;
+  this->tempBuffer = tempBuffer;
+  this->bufferSize = size;
+  this->ownsBuffers = false;
+}
+
+QRCodeEncodeContext::~QRCodeEncodeContext() {
+  if (ownsBuffers) {
+    free(qrcodeBuffer);
+    free(tempBuffer);
+  }
+  free(maskBuffers);
+}
+
+void* QRCodeEncodeContext::allocate(size_t size) {
+  void *buffer = malloc(size);
+#ifdef QRCODE_STATS
+  if (buffer != NULL) {
+    lastStats.allocatedBytes += size;
+    lastStats.allocations++;
+    lastStats.heapBytes += size;
+    if (lastStats.heapBytes > lastStats.peakHeapBytes) {
+      lastStats.peakHeapBytes = lastStats.heapBytes;
+    }
+  }
+#endif
+  return buffer;
+}
+
+void QRCodeEncodeContext::deallocate(void *buffer, size_t size) {
+  free(buffer);
+#ifdef QRCODE_STATS
+  // Buffers kept from earlier encodes are not counted in heapBytes
+  if (buffer != NULL) {
+    lastStats.heapBytes = size < lastStats.heapBytes ? lastStats.heapBytes - size : 0;
+  }
+#endif
+}
+
+QRCodeEncodeContext& QRCodeEncodeContext::setCache(QRCodeCache *cache) {
+  this->cache = cache;
+  return *this;
+}
+
+QRCodeCache* QRCodeEncodeContext::getCache() {
+  return cache;
+}
+
+QRCodeEncodeContext& QRCodeEncodeContext::setMaskExecutor(QRCodeExecutor *executor, uint8_t minVersion) {
+  maskExecutor = executor;
+  parallelMaskMinVersion = minVersion;
+  return *this;
+}
+
+QRCodeExecutor* QRCodeEncodeContext::getMaskExecutor() {
+  return maskExecutor;
+}
+
+#ifdef QRCODE_STATS
+const QRCodeStats& QRCodeEncodeContext::getLastStats() {
+  return lastStats;
+}
+#endif
+
+uint8_t* QRCodeEncodeContext::getQRCodeBuffer() {
+  return qrcodeBuffer;
+}
+
+uint8_t* QRCodeEncodeContext::getTempBuffer() {
+  return tempBuffer;
+}
+
+uint16_t QRCodeEncodeContext::getBufferSize() {
+  return bufferSize;
+}
+
+bool QRCodeEncodeContext::reserve(uint16_t size) {
+  if (size <= bufferSize) {
+    return true;
+  }
+  if (!ownsBuffers) {
+    return false; // error: provided buffers too small for required version
+  }
+
+  // The old contents don't need to be kept, so free first and leave the most room for the new buffers
+  deallocate(qrcodeBuffer, bufferSize);
+  deallocate(tempBuffer, bufferSize);
+  qrcodeBuffer = (uint8_t *)allocate(size);
+  tempBuffer = (uint8_t *)allocate(size);
+  if (qrcodeBuffer == NULL || tempBuffer == NULL) {
+    deallocate(qrcodeBuffer, size);
+    deallocate(tempBuffer, size);
+    qrcodeBuffer = tempBuffer = NULL;
+    bufferSize = 0;
+    return false;
+  }
+
+  bufferSize = size;
+  return true;
+}
+
+uint8_t* QRCodeEncodeContext::reserveMaskBuffers(uint8_t maxVersion) {
+  if (maskExecutor == NULL || maxVersion < parallelMaskMinVersion) {
+    return NULL;
+  }
+
+  size_t size = (size_t)maskExecutor->getWorkerCount() * qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion);
+  if (size > maskBuffersSize) {
+    deallocate(maskBuffers, maskBuffersSize);
+    maskBuffers = (uint8_t *)allocate(size);
+    maskBuffersSize = maskBuffers != NULL ? size : 0; // without them, the masks are scored serially
+  }
+  return maskBuffers;
+}
+
+// Constructor
+
+QRCodeConfig::QRCodeConfig(QRCodeECCLevel errorCorrectionLevel, uint8_t minVersion, uint8_t maxVersion, QRCodeMask mask) {
+  if (minVersion > maxVersion) {
+    uint8_t temp = minVersion;
+    minVersion = maxVersion;
+    maxVersion = temp;
+  }
+
+  if (minVersion < 1) {
+    minVersion = 1;
+  }
+  if (maxVersion > 40) {
+    maxVersion = 40;
+  }
+  this->errorCorrectionLevel = errorCorrectionLevel;
+  this->minVersion = minVersion;
+  this->maxVersion = maxVersion;
+  this->mask = mask;
+}
+
+// Getters
+
+QRCodeECCLevel QRCodeConfig::getErrorCorrectionLevel() const {
+  return errorCorrectionLevel;
+}
+
+uint8_t QRCodeConfig::getMinVersion() const {
+  return minVersion;
+}
+
+uint8_t QRCodeConfig::getMaxVersion() const {
+  return maxVersion;
+}
+
+QRCodeMask QRCodeConfig::getMask() const {
+  return mask;
+}
+
+QRCodeConfig QRCodeConfig::withErrorCorrectionLevel(QRCodeECCLevel level) const {
+  return QRCodeConfig(level, minVersion, maxVersion, mask);
+}
+
+QRCodeConfig QRCodeConfig::withVersionRange(uint8_t minVersion, uint8_t maxVersion) const {
+  return QRCodeConfig(errorCorrectionLevel, minVersion, maxVersion, mask);
+}
+
+QRCodeConfig QRCodeConfig::withMask(QRCodeMask mask) const {
+  return QRCodeConfig(errorCorrectionLevel, minVersion, maxVersion, mask);
+}
+
+bool QRCodeConfig::getVersionRange(enum qrcodegen_Mode mode, size_t length, uint8_t &minVersion, uint8_t &maxVersion,
+                                   struct qrcodegen_Stats *stats) const {
+  minVersion = this->minVersion;
+  maxVersion = this->maxVersion;
+
+#ifndef QRCODE_GENERATOR_USE_LESS_MEMORY
+  uint8_t version = qrcodegen_getMinVersion(mode, length, (enum qrcodegen_Ecc)errorCorrectionLevel,
+                                            minVersion, maxVersion, stats);
+  if (version == 0) {
+    return false;
+  }
+
+  minVersion = version;
+  maxVersion = version;
+#endif
+
+  return true;
+}
+
+QRCodeCacheKey QRCodeConfig::getCacheKey(const uint8_t *payload, size_t length, bool binary, bool payloadInFlash) const {
+  QRCodeCacheKey key;
+  key.hash = QRCodeCache::hash(payload, length, payloadInFlash);
+  key.length = length;
+  key.binary = binary;
+  key.errorCorrectionLevel = (uint8_t)errorCorrectionLevel;
+  key.minVersion = minVersion;
+  key.maxVersion = maxVersion;
+  key.mask = (int8_t)mask;
+  return key;
+}
+
+// Encoding steps
+
+const uint8_t* QRCodeConfig::findInCache(QRCodeCache *cache, QRCodeCacheKey &key, const uint8_t *payload, size_t length,
+                                         bool binary, bool payloadInFlash, uint8_t maxVersion) const {
+  if (cache == NULL) {
+    return NULL;
+  }
+
+  key = getCacheKey(payload, length, binary, payloadInFlash);
+  const uint8_t *cachedQRCode = cache->find(key, payload, payloadInFlash);
+  if (cachedQRCode == NULL || cachedQRCode[0] > maxVersion * 4 + 17) {
+    return NULL; // the cached symbol wouldn't fit the buffers, encode it again within maxVersion
+  }
+  return cachedQRCode;
+}
+
+bool QRCodeConfig::encodeText(const char *text, const struct qrcodegen_TextInfo &info, uint8_t minVersion, uint8_t maxVersion,
+                              uint8_t *tempBuffer, uint8_t *qrcodeBuffer, QRCodeExecutor *maskExecutor, uint8_t *maskBuffers,
+                              struct qrcodegen_Stats *stats) const {
+  if (qrcodegen_calcSegmentBufferSize(info.mode, info.length) > (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion)) {
+    return false; // error: text too long for the version range
+  }
+  struct qrcodegen_Segment segment = qrcodegen_beginSegment(info.mode, tempBuffer);
+  qrcodegen_appendToSegment(&segment, text, info.length);
+  return encodeSegments(&segment, info.length > 0 ? 1 : 0, minVersion, maxVersion, tempBuffer, qrcodeBuffer,
+                        maskExecutor, maskBuffers, stats);
+}
+
+bool QRCodeConfig::encodeSegments(const struct qrcodegen_Segment *segments, size_t count, uint8_t minVersion, uint8_t maxVersion,
+                                  uint8_t *tempBuffer, uint8_t *qrcodeBuffer, QRCodeExecutor *maskExecutor, uint8_t *maskBuffers,
+                                  struct qrcodegen_Stats *stats) const {
+  if (maskExecutor == NULL || maskBuffers == NULL) {
+    // What qrcodegen_encodeSegmentsAdvanced does, with this encode's own stats
+    struct qrcodegen_Encoder encoder;
+    if (!qrcodegen_beginEncode(&encoder, segments, count, (enum qrcodegen_Ecc)errorCorrectionLevel, minVersion, maxVersion,
+                               (enum qrcodegen_Mask)mask, false, tempBuffer, qrcodeBuffer, stats)) {
+      return false; // error: data too long for the version range
+    }
+    while (qrcodegen_encodeStep(&encoder) != qrcodegen_EncodePhase_DONE);
+    return true;
+  }
+
+  struct qrcodegen_MaskExecutor executor;
+  executor.parallelFor = parallelForMasks;
+  executor.executorContext = maskExecutor;
+  executor.workerCount = maskExecutor->getWorkerCount();
+  return qrcodegen_encodeSegmentsParallel(segments, count, (enum qrcodegen_Ecc)errorCorrectionLevel,
+                                          minVersion, maxVersion, false, tempBuffer, qrcodeBuffer, &executor, maskBuffers, stats);
+}
+
+// Adapts the qrcodegen executor interface to QRCodeExecutor
+struct QRCodeMaskJob {
+  void (*task)(int index, int worker, void *taskContext);
+  void *taskContext;
+};
+
+void QRCodeConfig::parallelForMasks(int count, void (*task)(int index, int worker, void *taskContext),
+                                    void *taskContext, void *executorContext) {
+  QRCodeMaskJob job = {task, taskContext};
+  ((QRCodeExecutor *)executorContext)->parallelFor(count, runMaskTask, &job);
+}
+
+void QRCodeConfig::runMaskTask(size_t index, uint8_t worker, void *context) {
+  QRCodeMaskJob *job = (QRCodeMaskJob *)context;
+  job->task((int)index, worker, job->taskContext);
+}
+
+// Encoding methods
+
+uint8_t* QRCodeConfig::encode(const char *text, QRCodeEncodeContext &context) const {
+  QRCODE_STATS_SCOPE(context.lastStats);
+
+  struct qrcodegen_TextInfo info = qrcodegen_analyzeText(text);
+
+  uint8_t minVersion, maxVersion;
+  if (!getVersionRange(info.mode, info.length, minVersion, maxVersion, QRCODE_ENCODE_STATS(context.lastStats))) {
+    return NULL; // error: text too long for the version range
+  }
+  // Shrink the range to what provided buffers can hold
+  while (maxVersion >= minVersion && qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion) > context.getBufferSize()
+         && !context.reserve(qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion))) {
+    maxVersion--;
+  }
+  if (maxVersion < minVersion) {
+    return NULL; // error: buffers too small or not enough memory
+  }
+
+  QRCodeCache *cache = context.getCache();
+  uint8_t *qrcodeBuffer = context.getQRCodeBuffer();
+  QRCodeCacheKey key;
+  const uint8_t *cachedQRCode = findInCache(cache, key, (const uint8_t *)text, info.length, false, false, maxVersion);
+  if (cachedQRCode != NULL) {
+    memcpy(qrcodeBuffer, cachedQRCode, qrcodegen_BUFFER_LEN_FOR_VERSION((cachedQRCode[0] - 17) / 4));
+    return qrcodeBuffer;
+  }
+
+  uint8_t *maskBuffers = mask == QRCodeMask::Auto ? context.reserveMaskBuffers(maxVersion) : NULL;
+  bool success = encodeText(text, info, minVersion, maxVersion, context.getTempBuffer(), qrcodeBuffer,
+                            maskBuffers != NULL ? context.getMaskExecutor() : NULL, maskBuffers,
+                            QRCODE_ENCODE_STATS(context.lastStats));
+  if (!success) {
+    return NULL;
+  }
+
+  if (cache != NULL) {
+    uint16_t qrcodeLength = qrcodegen_BUFFER_LEN_FOR_VERSION((qrcodeBuffer[0] - 17) / 4);
+    uint8_t *cacheSlot = cache->add(key, (const uint8_t *)text, false, qrcodeLength);
+    if (cacheSlot != NULL) {
+      memcpy(cacheSlot, qrcodeBuffer, qrcodeLength);
+    }
+  }
+  return qrcodeBuffer;
+}
+
+uint8_t* QRCodeConfig::encode(const uint8_t *data, size_t length, QRCodeEncodeContext &context) const {
+  QRCODE_STATS_SCOPE(context.lastStats);
+
+  if (qrcodegen_calcSegmentBufferSize(qrcodegen_Mode_BYTE, length) == SIZE_MAX) {
+    return NULL; // error: data too long for any QR Code
+  }
+
+  uint8_t minVersion, maxVersion;
+  if (!getVersionRange(qrcodegen_Mode_BYTE, length, minVersion, maxVersion, QRCODE_ENCODE_STATS(context.lastStats))) {
+    return NULL; // error: data too long for the version range
+  }
+  while (maxVersion >= minVersion && qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion) > context.getBufferSize()
+         && !context.reserve(qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion))) {
+    maxVersion--;
+  }
+  if (maxVersion < minVersion) {
+    return NULL; // error: buffers too small or not enough memory
+  }
+
+  QRCodeCache *cache = context.getCache();
+  uint8_t *qrcodeBuffer = context.getQRCodeBuffer();
+  QRCodeCacheKey key;
+  const uint8_t *cachedQRCode = findInCache(cache, key, data, length, true, false, maxVersion);
+  if (cachedQRCode != NULL) {
+    memcpy(qrcodeBuffer, cachedQRCode, qrcodegen_BUFFER_LEN_FOR_VERSION((cachedQRCode[0] - 17) / 4));
+    return qrcodeBuffer;
+  }
+
+  // The segment points straight to the caller's data, the encoder only reads from it
+  struct qrcodegen_Segment segment;
+  segment.mode = qrcodegen_Mode_BYTE;
+  segment.numChars = (int)length;
+  segment.bitLength = (int)length * 8;
+  segment.data = (uint8_t *)data;
+
+  uint8_t *maskBuffers = mask == QRCodeMask::Auto ? context.reserveMaskBuffers(maxVersion) : NULL;
+  bool success = encodeSegments(&segment, 1, minVersion, maxVersion, context.getTempBuffer(), qrcodeBuffer,
+                                maskBuffers != NULL ? context.getMaskExecutor() : NULL, maskBuffers,
+                                QRCODE_ENCODE_STATS(context.lastStats));
+  if (!success) {
+    return NULL;
+  }
+
+  if (cache != NULL) {
+    uint16_t qrcodeLength = qrcodegen_BUFFER_LEN_FOR_VERSION((qrcodeBuffer[0] - 17) / 4);
+    uint8_t *cacheSlot = cache->add(key, data, false, qrcodeLength);
+    if (cacheSlot != NULL) {
+      memcpy(cacheSlot, qrcodeBuffer, qrcodeLength);
+    }
+  }
+  return qrcodeBuffer;
+}
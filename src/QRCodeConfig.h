@@ -0,0 +1,158 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "qrcodegen.h"
+#include "QRCodeCache.h"
+#include "QRCodeExecutor.h"
+#include "QRCodeStats.h"
+#include "QRCodeSettings.h"
+
+enum class QRCodeECCLevel {
+  Low,
+  Medium,
+  Quartile,
+  High
+};
+
+// Auto tries all 8 mask patterns and keeps the most readable one (the slowest step of generation)
+// Forcing a pattern skips that search
+enum class QRCodeMask {
+  Auto = -1,
+  M0, M1, M2, M3, M4, M5, M6, M7
+};
+
+// Working memory of an encode: the qrcode and temp buffers, plus an optional cache and mask executor
+// Give each thread or task its own context, and they can all encode with one shared QRCodeConfig
+class QRCodeEncodeContext {
+private:
+  uint8_t *qrcodeBuffer = NULL;
+  uint8_t *tempBuffer = NULL;
+  uint16_t bufferSize = 0;
+  bool ownsBuffers = true;
+  QRCodeCache *cache = NULL;
+
+  // One grid per mask executor worker, grown like the other buffers (always allocated by the context)
+  QRCodeExecutor *maskExecutor = NULL;
+  uint8_t parallelMaskMinVersion = 25;
+  uint8_t *maskBuffers = NULL;
+  size_t maskBuffersSize = 0;
+
+#ifdef QRCODE_STATS
+  QRCodeStats lastStats = {};
+#endif
+
+  // Every heap buffer of the context goes through these, so the stats can follow heap usage
+  void* allocate(size_t size);
+  void deallocate(void *buffer, size_t size);
+
+  // QRCodeConfig::encode fills the stats and asks for the mask buffers
+  friend class QRCodeConfig;
+
+public:
+  // Constructor
+  // Without buffers, they are allocated on the first encode and grown when a larger version is needed
+  QRCodeEncodeContext();
+  QRCodeEncodeContext(uint8_t *qrcodeBuffer, uint8_t *tempBuffer, uint16_t size);
+
+  // Destructor
+  ~QRCodeEncodeContext();
+
+  // Contexts own their buffers, so they can't be copied
+  QRCodeEncodeContext(const QRCodeEncodeContext&) = delete;
+  QRCodeEncodeContext& operator=(const QRCodeEncodeContext&) = delete;
+
+  // Getters and setters
+  // A cache is not thread-safe, so it must not be shared with contexts used at the same time
+  QRCodeEncodeContext& setCache(QRCodeCache *cache);
+  QRCodeCache* getCache();
+  // Same as QRCodeGenerator::setMaskExecutor, the executor must not be shared with contexts used at the same time
+  QRCodeEncodeContext& setMaskExecutor(QRCodeExecutor *executor, uint8_t minVersion = 25);
+  QRCodeExecutor* getMaskExecutor();
+  uint8_t* getQRCodeBuffer();
+  uint8_t* getTempBuffer();
+  uint16_t getBufferSize();
+
+#ifdef QRCODE_STATS
+  // Phase timings and counts of the last encode with this context
+  // The encoding phases are counted globally, so they mix up if other threads encode at the same time
+  const QRCodeStats& getLastStats();
+#endif
+
+  // Makes sure both buffers hold at least size bytes (false if they can't)
+  bool reserve(uint16_t size);
+
+  // Grids for the mask executor's workers, when it's worth using for maxVersion (NULL if not, or if they don't fit in memory)
+  uint8_t* reserveMaskBuffers(uint8_t maxVersion);
+};
+
+// Encoding settings, which never change once built
+// The encode methods are const and keep all their state in the context, so one config can be shared
+// by any number of threads or tasks at the same time, without a lock
+//   const QRCodeConfig config(QRCodeECCLevel::Medium, 1, 10);
+//   QRCodeEncodeContext context; // one per thread
+//   uint8_t *data = config.encode(text, context);
+class QRCodeConfig {
+private:
+  QRCodeECCLevel errorCorrectionLevel;
+  uint8_t minVersion;
+  uint8_t maxVersion;
+  QRCodeMask mask;
+
+  static void parallelForMasks(int count, void (*task)(int index, int worker, void *taskContext),
+                               void *taskContext, void *executorContext);
+  static void runMaskTask(size_t index, uint8_t worker, void *context);
+
+public:
+  // Constructor
+  // The version range is sorted and clamped to [1, 40]
+  QRCodeConfig(QRCodeECCLevel errorCorrectionLevel = QRCodeECCLevel::Low, uint8_t minVersion = 1, uint8_t maxVersion = 40,
+               QRCodeMask mask = QRCodeMask::Auto);
+
+  // Getters
+  QRCodeECCLevel getErrorCorrectionLevel() const;
+  uint8_t getMinVersion() const;
+  uint8_t getMaxVersion() const;
+  QRCodeMask getMask() const;
+
+  // Copies with one setting changed
+  QRCodeConfig withErrorCorrectionLevel(QRCodeECCLevel level) const;
+  QRCodeConfig withVersionRange(uint8_t minVersion, uint8_t maxVersion) const;
+  QRCodeConfig withMask(QRCodeMask mask) const;
+
+  // Narrows the version range for a payload (to its minimum version, unless QRCODE_GENERATOR_USE_LESS_MEMORY is defined)
+  // Returns false if the payload doesn't fit any version in the range
+  // stats, when given, receives the counters of the search (see qrcodegen_Stats)
+  bool getVersionRange(enum qrcodegen_Mode mode, size_t length, uint8_t &minVersion, uint8_t &maxVersion,
+                       struct qrcodegen_Stats *stats = NULL) const;
+
+  // Identifies a payload encoded with these settings in a QRCodeCache
+  QRCodeCacheKey getCacheKey(const uint8_t *payload, size_t length, bool binary, bool payloadInFlash) const;
+
+  // Steps shared by encode() and QRCodeGenerator, so both paths behave the same
+  // findInCache fills key and returns the cached symbol, only if it fits maxVersion (the buffers may be sized for less)
+  const uint8_t* findInCache(QRCodeCache *cache, QRCodeCacheKey &key, const uint8_t *payload, size_t length, bool binary,
+                             bool payloadInFlash, uint8_t maxVersion) const;
+  // Encode into qrcodeBuffer, scoring the masks on maskExecutor if given
+  // maskBuffers then holds one grid of qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion) bytes per worker
+  // stats, when given, receives the counters of the encoding phases
+  bool encodeText(const char *text, const struct qrcodegen_TextInfo &info, uint8_t minVersion, uint8_t maxVersion,
+                  uint8_t *tempBuffer, uint8_t *qrcodeBuffer, QRCodeExecutor *maskExecutor = NULL, uint8_t *maskBuffers = NULL,
+                  struct qrcodegen_Stats *stats = NULL) const;
+  bool encodeSegments(const struct qrcodegen_Segment *segments, size_t count, uint8_t minVersion, uint8_t maxVersion,
+                      uint8_t *tempBuffer, uint8_t *qrcodeBuffer, QRCodeExecutor *maskExecutor = NULL, uint8_t *maskBuffers = NULL,
+                      struct qrcodegen_Stats *stats = NULL) const;
+
+  // Encoding methods
+  // They write into the context's qrcode buffer and return it (NULL on failure)
+  // The data stays valid until the context is used again
+  uint8_t* encode(const char *text, QRCodeEncodeContext &context) const;
+  uint8_t* encode(const uint8_t *data, size_t length, QRCodeEncodeContext &context) const;
+};
@@ -0,0 +1,207 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeDisplayList.h"
+
+// Constructor
+
+QRCodeDisplayList::QRCodeDisplayList() {
+}
+
+// Destructor
+
+QRCodeDisplayList::~QRCodeDisplayList() {
+  clear();
+}
+
+// Building methods
+
+bool QRCodeDisplayList::build(const uint8_t *qrcode) {
+  return build(qrcode, false);
+}
+
+bool QRCodeDisplayList::build(const QRCodeStaticData &data) {
+  return build(data.qrcode, true);
+}
+
+bool QRCodeDisplayList::build(const uint8_t *qrcode, bool inFlash) {
+  clear();
+  if (qrcode == NULL) {
+    return false;
+  }
+
+  // Count first, so the list is allocated once with its exact size
+  uint16_t count = findRects(qrcode, inFlash, NULL);
+  if (count == UINT16_MAX) {
+    return false; // error: not enough memory to find the rectangles
+  }
+  rects = (Rect *)malloc(count * sizeof(Rect));
+  if (rects == NULL || findRects(qrcode, inFlash, rects) != count) {
+    clear();
+    return false;
+  }
+
+  rectCount = count;
+  size = inFlash ? pgm_read_byte(qrcode) : qrcode[0];
+  return true;
+}
+
+void QRCodeDisplayList::clear() {
+  free(rects);
+  rects = NULL;
+  rectCount = 0;
+  size = 0;
+}
+
+// Finds the rectangles row by row and returns how many there are (UINT16_MAX if it runs out of memory)
+// Each run of dark modules either makes the rectangle right above it (same columns, ending on the previous row)
+// one row taller, or starts a new one. Rectangles are only written if rects is not NULL
+uint16_t QRCodeDisplayList::findRects(const uint8_t *qrcode, bool inFlash, Rect *rects) {
+  // The runs of the previous and current rows, with the rectangle each one belongs to
+  struct Run {
+    uint8_t x;
+    uint8_t width;
+    uint16_t rect;
+  };
+
+  uint8_t size = inFlash ? pgm_read_byte(qrcode) : qrcode[0];
+  uint8_t maxRuns = (size + 1) / 2;
+  Run *runs = (Run *)malloc(2 * maxRuns * sizeof(Run));
+  if (runs == NULL) {
+    return UINT16_MAX;
+  }
+  Run *previousRuns = runs;
+  Run *currentRuns = runs + maxRuns;
+  uint8_t previousCount = 0;
+  uint16_t count = 0;
+
+  for (uint8_t y = 0; y < size; y++) {
+    uint8_t currentCount = 0;
+    uint8_t previous = 0;
+    uint8_t x = 0;
+    while (x < size) {
+      // Same bit layout as qrcodegen_getModule, which can't read from flash
+      int index = y * size + x;
+      uint8_t modules = inFlash ? pgm_read_byte(qrcode + (index >> 3) + 1) : qrcode[(index >> 3) + 1];
+      if (((modules >> (index & 7)) & 1) == 0) {
+        x++;
+        continue;
+      }
+
+      uint8_t width = 1;
+      while (x + width < size) {
+        index++;
+        modules = inFlash ? pgm_read_byte(qrcode + (index >> 3) + 1) : qrcode[(index >> 3) + 1];
+        if (((modules >> (index & 7)) & 1) == 0) {
+          break;
+        }
+        width++;
+      }
+
+      // Runs are sorted by column, so the one above (if any) is found by walking the previous row once
+      while (previous < previousCount && previousRuns[previous].x < x) {
+        previous++;
+      }
+      Run &run = currentRuns[currentCount++];
+      run.x = x;
+      run.width = width;
+      if (previous < previousCount && previousRuns[previous].x == x && previousRuns[previous].width == width) {
+        run.rect = previousRuns[previous].rect;
+        if (rects != NULL) {
+          rects[run.rect].height++;
+        }
+      }
+      else {
+        run.rect = count++;
+        if (rects != NULL) {
+          rects[run.rect] = {x, y, width, 1};
+        }
+      }
+      x += width;
+    }
+
+    Run *swap = previousRuns;
+    previousRuns = currentRuns;
+    currentRuns = swap;
+    previousCount = currentCount;
+  }
+
+  free(runs);
+  return count;
+}
+
+// Getters
+
+bool QRCodeDisplayList::isEmpty() const {
+  return size == 0;
+}
+
+uint8_t QRCodeDisplayList::getSize() const {
+  return size;
+}
+
+uint16_t QRCodeDisplayList::getRectCount() const {
+  return rectCount;
+}
+
+size_t QRCodeDisplayList::getBytes() const {
+  return rectCount * sizeof(Rect);
+}
+
+int16_t QRCodeDisplayList::getSideLength(uint16_t scale) const {
+  // Same quiet zone as QRCodeGFX: 3 modules on each side
+  return size == 0 ? 0 : (size + 6) * scale;
+}
+
+// Drawing methods
+
+void QRCodeDisplayList::replay(Adafruit_GFX &display, int16_t x, int16_t y, uint16_t scale, QRCodeRotation rotation,
+                               uint16_t backgroundColor, uint16_t foregroundColor) const {
+  if (size == 0) {
+    return;
+  }
+
+  int16_t side = getSideLength(scale);
+  display.fillRect(x, y, side, side, backgroundColor);
+
+  int16_t padding = scale * 3;
+  x += padding;
+  y += padding;
+  for (uint16_t i = 0; i < rectCount; i++) {
+    const Rect &rect = rects[i];
+    // Where the rectangle lands on screen, in modules (rotations are clockwise, like QRCodeGFX)
+    uint8_t screenX, screenY, screenWidth, screenHeight;
+    switch (rotation) {
+      case QRCodeRotation::R0:
+        screenX = rect.x;
+        screenY = rect.y;
+        screenWidth = rect.width;
+        screenHeight = rect.height;
+        break;
+      case QRCodeRotation::R90:
+        screenX = size - rect.y - rect.height;
+        screenY = rect.x;
+        screenWidth = rect.height;
+        screenHeight = rect.width;
+        break;
+      case QRCodeRotation::R180:
+        screenX = size - rect.x - rect.width;
+        screenY = size - rect.y - rect.height;
+        screenWidth = rect.width;
+        screenHeight = rect.height;
+        break;
+      default: // R270
+        screenX = rect.y;
+        screenY = size - rect.x - rect.width;
+        screenWidth = rect.height;
+        screenHeight = rect.width;
+        break;
+    }
+    display.fillRect(x + screenX * scale, y + screenY * scale, screenWidth * scale, screenHeight * scale, foregroundColor);
+  }
+}
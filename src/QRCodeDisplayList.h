@@ -0,0 +1,70 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+#include "QRCodeGFX.h"
+
+// A QR Code turned into a list of rectangles, to draw it many times (at other positions, scales,
+// rotations or colors) without walking the module grid again
+// Dark modules are merged into horizontal runs, and runs repeated on the next rows into taller rectangles,
+// so replaying costs one fillRect per rectangle plus one for the background: about 4 times fewer calls than draw()
+// The price is memory: each rectangle takes 4 bytes, and there is about one rectangle per 4 or 5 modules
+// (around 500 bytes for version 2, 28 KB for version 40), about 7 times the QR Code data, which can be released
+//   QRCodeDisplayList list;
+//   qrcode.generateData(text);
+//   qrcode.buildDisplayList(list);
+//   qrcode.draw(list, x, y); // as many times as needed, with any settings
+class QRCodeDisplayList {
+private:
+  // A rectangle of dark modules, in module coordinates of the unrotated QR Code
+  struct Rect {
+    uint8_t x;
+    uint8_t y;
+    uint8_t width;
+    uint8_t height;
+  };
+
+  Rect *rects = NULL;
+  uint16_t rectCount = 0;
+  uint8_t size = 0;
+
+  bool build(const uint8_t *qrcode, bool inFlash);
+  static uint16_t findRects(const uint8_t *qrcode, bool inFlash, Rect *rects);
+
+public:
+  // Constructor
+  QRCodeDisplayList();
+
+  // Destructor
+  ~QRCodeDisplayList();
+
+  // Lists own their rectangles, so they can't be copied
+  QRCodeDisplayList(const QRCodeDisplayList&) = delete;
+  QRCodeDisplayList& operator=(const QRCodeDisplayList&) = delete;
+
+  // Builds the list from QR Code data (e.g. returned by QRCodeGenerator::generateData) or a static QR Code
+  // Any previous list is replaced. Returns false if there is not enough memory (the list is then empty)
+  bool build(const uint8_t *qrcode);
+  bool build(const QRCodeStaticData &data);
+  void clear();
+
+  // Getters
+  bool isEmpty() const;
+  uint8_t getSize() const;         // modules per side, 0 if empty
+  uint16_t getRectCount() const;
+  size_t getBytes() const;         // heap used by the rectangles
+  int16_t getSideLength(uint16_t scale) const;
+
+  // Draws the QR Code with its quiet zone, like QRCodeGFX::draw with the same settings
+  // The background is a single fillRect, then each rectangle is transformed and drawn with one fillRect
+  void replay(Adafruit_GFX &display, int16_t x, int16_t y, uint16_t scale, QRCodeRotation rotation,
+              uint16_t backgroundColor, uint16_t foregroundColor) const;
+};
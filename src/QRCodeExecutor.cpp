@@ -0,0 +1,236 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeExecutor.h"
+
+#ifdef ESP32
+#include <esp_pthread.h>
+#endif
+
+// Serial executor
+
+uint8_t QRCodeSerialExecutor::getWorkerCount() {
+  return 1;
+}
+
+void QRCodeSerialExecutor::parallelFor(size_t count, QRCodeTask task, void *context) {
+  for (size_t i = 0; i < count; i++) {
+    task(i, 0, context);
+  }
+}
+
+#ifdef QRCODE_THREAD_POOL_ENABLED
+
+#ifdef ESP32
+
+// Stack of the executor threads: the encode itself takes about 1 KB, but the tasks and callbacks
+// they run (drawing, Serial...) are user code, and the pthread default is only 3 KB
+#define EXECUTOR_STACK_SIZE 8192
+
+// std::thread runs on a pthread, which is a FreeRTOS task configured through esp_pthread
+// That setting applies to every thread the calling task creates later, so it's only changed
+// while this object exists, and the caller's own setting is restored afterwards
+class QRCodeThreadConfig {
+private:
+  esp_pthread_cfg_t previous;
+  bool hadPrevious;
+
+public:
+  QRCodeThreadConfig(int8_t core) {
+    hadPrevious = esp_pthread_get_cfg(&previous) == ESP_OK;
+    esp_pthread_cfg_t config = esp_pthread_get_default_config();
+    config.stack_size = EXECUTOR_STACK_SIZE;
+    if (core >= 0) {
+      config.pin_to_core = core;
+    }
+    esp_pthread_set_cfg(&config);
+  }
+
+  ~QRCodeThreadConfig() {
+    esp_pthread_cfg_t config = hadPrevious ? previous : esp_pthread_get_default_config();
+    esp_pthread_set_cfg(&config);
+  }
+};
+
+#endif
+
+// Constructor
+
+QRCodeThreadPool::QRCodeThreadPool(uint8_t workerCount) {
+  if (workerCount == 0) {
+    unsigned int hardwareThreads = std::thread::hardware_concurrency();
+    workerCount = hardwareThreads == 0 ? 1 : hardwareThreads > 255 ? 255 : hardwareThreads;
+  }
+  this->workerCount = workerCount;
+
+  workers = new Worker[workerCount];
+  threads = new std::thread[workerCount - 1];
+#ifdef ESP32
+  QRCodeThreadConfig threadConfig(-1);
+#endif
+  for (uint8_t i = 1; i < workerCount; i++) {
+    threads[i - 1] = std::thread(&QRCodeThreadPool::waitForJobs, this, i);
+  }
+}
+
+// Destructor
+
+QRCodeThreadPool::~QRCodeThreadPool() {
+  {
+    std::lock_guard<std::mutex> guard(jobLock);
+    stopping = true;
+  }
+  jobStarted.notify_all();
+
+  for (uint8_t i = 1; i < workerCount; i++) {
+    threads[i - 1].join();
+  }
+  delete[] threads;
+  delete[] workers;
+}
+
+uint8_t QRCodeThreadPool::getWorkerCount() {
+  return workerCount;
+}
+
+void QRCodeThreadPool::parallelFor(size_t count, QRCodeTask task, void *context) {
+  if (count == 0) {
+    return;
+  }
+
+  // Contiguous shares keep neighbouring items on the same worker
+  for (uint8_t i = 0; i < workerCount; i++) {
+    std::lock_guard<std::mutex> guard(workers[i].lock);
+    workers[i].begin = count * i / workerCount;
+    workers[i].end = count * (i + 1) / workerCount;
+  }
+
+  {
+    std::lock_guard<std::mutex> guard(jobLock);
+    this->task = task;
+    this->context = context;
+    busyWorkers = workerCount - 1;
+    jobNumber++;
+  }
+  jobStarted.notify_all();
+
+  work(0);
+
+  std::unique_lock<std::mutex> guard(jobLock);
+  jobFinished.wait(guard, [this] { return busyWorkers == 0; });
+}
+
+void QRCodeThreadPool::waitForJobs(uint8_t worker) {
+  uint32_t lastJobNumber = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> guard(jobLock);
+      jobStarted.wait(guard, [this, lastJobNumber] { return stopping || jobNumber != lastJobNumber; });
+      if (stopping) {
+        return;
+      }
+      lastJobNumber = jobNumber;
+    }
+
+    work(worker);
+
+    std::lock_guard<std::mutex> guard(jobLock);
+    busyWorkers--;
+    if (busyWorkers == 0) {
+      jobFinished.notify_one();
+    }
+  }
+}
+
+void QRCodeThreadPool::work(uint8_t worker) {
+  size_t index;
+  while (takeIndex(worker, index) || stealIndex(worker, index)) {
+    task(index, worker, context);
+  }
+}
+
+bool QRCodeThreadPool::takeIndex(uint8_t worker, size_t &index) {
+  std::lock_guard<std::mutex> guard(workers[worker].lock);
+  if (workers[worker].begin == workers[worker].end) {
+    return false;
+  }
+  index = workers[worker].begin++;
+  return true;
+}
+
+bool QRCodeThreadPool::stealIndex(uint8_t thief, size_t &index) {
+  for (uint8_t i = 1; i < workerCount; i++) {
+    Worker &victim = workers[(thief + i) % workerCount];
+    std::lock_guard<std::mutex> guard(victim.lock);
+    if (victim.begin < victim.end) {
+      index = --victim.end; // the owner takes from the other end
+      return true;
+    }
+  }
+  return false;
+}
+
+// Background executor
+
+QRCodeBackgroundExecutor::QRCodeBackgroundExecutor(int8_t core) {
+#ifdef ESP32
+  QRCodeThreadConfig threadConfig(core);
+#endif
+
+  thread = std::thread(&QRCodeBackgroundExecutor::runJobs, this);
+}
+
+QRCodeBackgroundExecutor::~QRCodeBackgroundExecutor() {
+  {
+    std::lock_guard<std::mutex> guard(queueLock);
+    stopping = true;
+  }
+  jobQueued.notify_one();
+  thread.join();
+}
+
+uint8_t QRCodeBackgroundExecutor::getWorkerCount() {
+  return 1;
+}
+
+void QRCodeBackgroundExecutor::parallelFor(size_t count, QRCodeTask task, void *context) {
+  for (size_t i = 0; i < count; i++) {
+    task(i, 0, context);
+  }
+}
+
+void QRCodeBackgroundExecutor::submit(QRCodeTask task, void *context) {
+  {
+    std::unique_lock<std::mutex> guard(queueLock);
+    jobTaken.wait(guard, [this] { return queueCount < QUEUE_LENGTH; });
+    queue[(queueStart + queueCount) % QUEUE_LENGTH] = {task, context};
+    queueCount++;
+  }
+  jobQueued.notify_one();
+}
+
+void QRCodeBackgroundExecutor::runJobs() {
+  while (true) {
+    Job job;
+    {
+      std::unique_lock<std::mutex> guard(queueLock);
+      jobQueued.wait(guard, [this] { return stopping || queueCount > 0; });
+      if (queueCount == 0) {
+        return; // stopping, and nothing left to run
+      }
+      job = queue[queueStart];
+      queueStart = (queueStart + 1) % QUEUE_LENGTH;
+      queueCount--;
+    }
+    jobTaken.notify_one();
+
+    job.task(0, 0, job.context);
+  }
+}
+
+#endif
@@ -0,0 +1,130 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+
+// A task run by an executor for one index
+// worker identifies the worker running it, in [0, getWorkerCount()), so tasks can pick their own scratch memory
+typedef void (*QRCodeTask)(size_t index, uint8_t worker, void *context);
+
+// Runs tasks for a range of indices, possibly in parallel
+class QRCodeExecutor {
+public:
+  virtual ~QRCodeExecutor() {}
+
+  virtual uint8_t getWorkerCount() = 0;
+
+  // Runs task for every index in [0, count) and returns when all of them are done
+  virtual void parallelFor(size_t count, QRCodeTask task, void *context) = 0;
+
+  // Runs task(0, 0, context) once, in the background if the executor can, and may return before it's done
+  // By default it runs in the calling thread before returning
+  virtual void submit(QRCodeTask task, void *context) {
+    task(0, 0, context);
+  }
+};
+
+// Runs every task in the calling thread, in order
+class QRCodeSerialExecutor : public QRCodeExecutor {
+public:
+  uint8_t getWorkerCount() override;
+  void parallelFor(size_t count, QRCodeTask task, void *context) override;
+};
+
+// Threads are only available on hosted builds and on ESP32 (FreeRTOS with pthreads)
+// On ESP32 the executors' threads get an 8 KB stack, so tasks and callbacks can also draw or print
+#if !defined(ARDUINO) || defined(ESP32)
+
+#define QRCODE_THREAD_POOL_ENABLED
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+// Keeps workerCount - 1 threads waiting for work (the thread calling parallelFor is the last worker)
+// Each worker gets a contiguous share of the indices and, once done, steals from the end of the others' shares
+// parallelFor must not be called from two threads at the same time
+class QRCodeThreadPool : public QRCodeExecutor {
+private:
+  struct Worker {
+    std::mutex lock;
+    size_t begin = 0;
+    size_t end = 0;
+  };
+
+  uint8_t workerCount;
+  Worker *workers;
+  std::thread *threads;
+
+  std::mutex jobLock;
+  std::condition_variable jobStarted;
+  std::condition_variable jobFinished;
+  uint32_t jobNumber = 0;
+  uint8_t busyWorkers = 0;
+  bool stopping = false;
+  QRCodeTask task = NULL;
+  void *context = NULL;
+
+  void waitForJobs(uint8_t worker);
+  void work(uint8_t worker);
+  bool takeIndex(uint8_t worker, size_t &index);
+  bool stealIndex(uint8_t thief, size_t &index);
+
+public:
+  // Constructor
+  // workerCount 0 uses one worker per hardware thread
+  QRCodeThreadPool(uint8_t workerCount = 0);
+
+  // Destructor
+  ~QRCodeThreadPool();
+
+  uint8_t getWorkerCount() override;
+  void parallelFor(size_t count, QRCodeTask task, void *context) override;
+};
+
+// Runs submitted tasks one after the other on its own thread, so the caller doesn't wait for them
+// On ESP32 the thread can be pinned to a core (e.g. 0, while loop() runs on core 1); -1 lets the scheduler choose
+// parallelFor still blocks, running the whole range in the calling thread
+// Tasks that are still queued when it's destroyed are run before the thread ends
+class QRCodeBackgroundExecutor : public QRCodeExecutor {
+private:
+  struct Job {
+    QRCodeTask task;
+    void *context;
+  };
+
+  static constexpr uint8_t QUEUE_LENGTH = 8;
+  Job queue[QUEUE_LENGTH];
+  uint8_t queueStart = 0;
+  uint8_t queueCount = 0;
+  bool stopping = false;
+
+  std::mutex queueLock;
+  std::condition_variable jobQueued;
+  std::condition_variable jobTaken;
+  std::thread thread;
+
+  void runJobs();
+
+public:
+  // Constructor
+  QRCodeBackgroundExecutor(int8_t core = -1);
+
+  // Destructor
+  ~QRCodeBackgroundExecutor();
+
+  uint8_t getWorkerCount() override;
+  void parallelFor(size_t count, QRCodeTask task, void *context) override;
+
+  // Queues the task and returns right away (it only waits when 8 tasks are already queued)
+  void submit(QRCodeTask task, void *context) override;
+};
+
+#endif
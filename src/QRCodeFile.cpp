@@ -0,0 +1,176 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeFile.h"
+#include "qrcodegen.h"
+
+// CRC-32 remainders of a 4 bit value, half a byte at a time keeps the table small
+static const uint32_t crcTable[16] PROGMEM = {
+  0x00000000, 0x1DB71064, 0x3B6E20C8, 0x26D930AC, 0x76DC4190, 0x6B6B51F4, 0x4DB26158, 0x5005713C,
+  0xEDB88320, 0xF00F9344, 0xD6D6A3E8, 0xCB61B38C, 0x9B64C2B0, 0x86D3D2D4, 0xA00AE278, 0xBDBDF21C
+};
+
+static const uint8_t MAGIC[3] = { 'Q', 'R', 'C' };
+static const uint8_t HEADER_LENGTH = 7;
+static const uint8_t MAX_ROW_BYTES = (qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8;
+
+// Writes the rows of a record into QR Code data, if the buffer is big enough for its version
+class QRCodeBufferRowSink : public QRCodeRowSink {
+private:
+  uint8_t *qrcode;
+  size_t bufferLength;
+
+public:
+  bool fits = false;
+
+  QRCodeBufferRowSink(uint8_t *qrcode, size_t bufferLength) : qrcode(qrcode), bufferLength(bufferLength) {
+  }
+
+  void begin(uint8_t size) override {
+    fits = (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION((size - 17) / 4) <= bufferLength;
+    if (fits) {
+      memset(qrcode, 0, qrcodegen_BUFFER_LEN_FOR_VERSION((size - 17) / 4));
+      qrcode[0] = size;
+    }
+  }
+
+  void writeRow(uint8_t y, const uint8_t *modules, uint8_t size) override {
+    if (!fits) {
+      return;
+    }
+    for (uint8_t x = 0; x < size; x++) {
+      if (modules[x >> 3] & (0x80 >> (x & 7))) {
+        // Same bit layout as qrcodegen_getModule
+        int index = y * size + x;
+        qrcode[(index >> 3) + 1] |= 1 << (index & 7);
+      }
+    }
+  }
+};
+
+// Private methods
+
+uint32_t QRCodeFile::updateCrc(uint32_t crc, const uint8_t *data, size_t length) {
+  for (size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    crc = (crc >> 4) ^ pgm_read_dword(&crcTable[crc & 0x0F]);
+    crc = (crc >> 4) ^ pgm_read_dword(&crcTable[crc & 0x0F]);
+  }
+  return crc;
+}
+
+bool QRCodeFile::readRecord(Stream &stream, QRCodeFileHeader &header, QRCodeRowSink *sink) {
+  uint8_t bytes[HEADER_LENGTH];
+  if (stream.readBytes(bytes, HEADER_LENGTH) != HEADER_LENGTH) {
+    return false; // error: end of stream
+  }
+  if (memcmp(bytes, MAGIC, sizeof(MAGIC)) != 0 || bytes[3] != REVISION) {
+    return false; // error: not a QR Code file, or one from a later revision
+  }
+  if (bytes[4] < qrcodegen_VERSION_MIN || bytes[4] > qrcodegen_VERSION_MAX || bytes[5] > 3 || bytes[6] > 7) {
+    return false; // error: damaged header
+  }
+  header.version = bytes[4];
+  header.errorCorrectionLevel = (QRCodeECCLevel)bytes[5];
+  header.mask = (QRCodeMask)bytes[6];
+  uint32_t crc = updateCrc(0xFFFFFFFF, bytes, HEADER_LENGTH);
+
+  uint8_t size = header.version * 4 + 17;
+  uint8_t rowBytes = (size + 7) / 8;
+  uint8_t row[MAX_ROW_BYTES];
+  if (sink != NULL) {
+    sink->begin(size);
+  }
+  for (uint8_t y = 0; y < size; y++) {
+    if (stream.readBytes(row, rowBytes) != rowBytes) {
+      return false; // error: truncated record
+    }
+    crc = updateCrc(crc, row, rowBytes);
+    if (sink != NULL) {
+      sink->writeRow(y, row, size);
+    }
+  }
+  if (sink != NULL) {
+    sink->end();
+  }
+
+  if (stream.readBytes(bytes, 4) != 4) {
+    return false; // error: truncated record
+  }
+  uint32_t storedCrc = (uint32_t)bytes[0] << 24 | (uint32_t)bytes[1] << 16 | (uint32_t)bytes[2] << 8 | bytes[3];
+  return storedCrc == ~crc;
+}
+
+// Public methods
+
+size_t QRCodeFile::getRecordLength(uint8_t version) {
+  uint8_t size = version * 4 + 17;
+  return HEADER_LENGTH + (size_t)size * ((size + 7) / 8) + 4;
+}
+
+bool QRCodeFile::write(Print &out, const uint8_t *qrcode) {
+  if (qrcode == NULL || qrcode[0] < 21 || qrcode[0] > 177 || (qrcode[0] - 17) % 4 != 0) {
+    return false; // error: not QR Code data
+  }
+  uint8_t size = qrcode[0];
+
+  // Error correction level and mask from the first copy of the format information
+  uint16_t formatBits = 0;
+  for (uint8_t i = 0; i < 15; i++) {
+    bool bit = i < 6 ? qrcodegen_getModule(qrcode, 8, i)
+             : i < 8 ? qrcodegen_getModule(qrcode, 8, i + 1)
+             : i == 8 ? qrcodegen_getModule(qrcode, 7, 8)
+             : qrcodegen_getModule(qrcode, 14 - i, 8);
+    formatBits |= (uint16_t)bit << i;
+  }
+  uint8_t format = (formatBits ^ 0x5412) >> 10;
+
+  // The format information orders the levels M, L, H, Q
+  uint8_t header[HEADER_LENGTH] = { MAGIC[0], MAGIC[1], MAGIC[2], REVISION, (uint8_t)((size - 17) / 4),
+                                    (uint8_t)((format >> 3) ^ 1), (uint8_t)(format & 7) };
+  uint32_t crc = updateCrc(0xFFFFFFFF, header, HEADER_LENGTH);
+  if (out.write(header, HEADER_LENGTH) != HEADER_LENGTH) {
+    return false; // error: out is full or closed
+  }
+
+  uint8_t rowBytes = (size + 7) / 8;
+  uint8_t row[MAX_ROW_BYTES];
+  for (uint8_t y = 0; y < size; y++) {
+    memset(row, 0, rowBytes);
+    for (uint8_t x = 0; x < size; x++) {
+      if (qrcodegen_getModule(qrcode, x, y)) {
+        row[x >> 3] |= 0x80 >> (x & 7);
+      }
+    }
+    crc = updateCrc(crc, row, rowBytes);
+    if (out.write(row, rowBytes) != rowBytes) {
+      return false; // error: out is full or closed
+    }
+  }
+
+  crc = ~crc;
+  uint8_t crcBytes[4] = { (uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc };
+  return out.write(crcBytes, 4) == 4;
+}
+
+bool QRCodeFile::readRows(Stream &stream, QRCodeRowSink &sink, QRCodeFileHeader *header) {
+  QRCodeFileHeader localHeader;
+  return readRecord(stream, header != NULL ? *header : localHeader, &sink);
+}
+
+bool QRCodeFile::read(Stream &stream, uint8_t *qrcode, size_t bufferLength, QRCodeFileHeader *header) {
+  QRCodeBufferRowSink sink(qrcode, bufferLength);
+  QRCodeFileHeader localHeader;
+  bool valid = readRecord(stream, header != NULL ? *header : localHeader, &sink);
+  return valid && sink.fits; // error if false: damaged record, or buffer too small
+}
+
+bool QRCodeFile::verify(Stream &stream, QRCodeFileHeader *header) {
+  QRCodeFileHeader localHeader;
+  return readRecord(stream, header != NULL ? *header : localHeader, NULL);
+}
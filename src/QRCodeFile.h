@@ -0,0 +1,60 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "QRCodeConfig.h"
+#include "QRCodeRowSink.h"
+
+// What a QR Code file says about its symbol
+struct QRCodeFileHeader {
+  uint8_t version;
+  QRCodeECCLevel errorCorrectionLevel;
+  QRCodeMask mask;
+};
+
+// Finished QR Codes stored in files (SD card, SPIFFS, LittleFS) or any other Stream, to be drawn without encoding
+// Each record is:
+//   3 bytes  "QRC"
+//   1 byte   format revision (1)
+//   1 byte   QR Code version (1 to 40)
+//   1 byte   error correction level (0 to 3, in QRCodeECCLevel order)
+//   1 byte   mask (0 to 7)
+//   rows     for each row, top to bottom, (size + 7) / 8 bytes: the leftmost module in the most significant bit,
+//            1 for dark, unused bits 0
+//   4 bytes  CRC-32 (the one used by PNG and zip) of everything above, most significant byte first
+// Records can be stored back to back: all records of one version have the same length (see getRecordLength)
+// Write them on the board with write(), or on a computer with qrcodegen_writeSymbol() (see qrcodegen_image.h)
+// Reading only needs one row of RAM, the rows go to a QRCodeRowSink (or QRCodeGFX::drawFrom) as they arrive
+class QRCodeFile {
+private:
+  static uint32_t updateCrc(uint32_t crc, const uint8_t *data, size_t length);
+  static bool readRecord(Stream &stream, QRCodeFileHeader &header, QRCodeRowSink *sink);
+
+public:
+  static const uint8_t REVISION = 1;
+
+  // Bytes taken by a record of the given version
+  static size_t getRecordLength(uint8_t version);
+
+  // Writes QR Code data (e.g. returned by QRCodeGenerator::generateData) as a record
+  // Returns false if it is not QR Code data or if out didn't take all the bytes
+  static bool write(Print &out, const uint8_t *qrcode);
+
+  // Reads a record from the stream's current position, sending the rows to sink
+  // The checksum can only be checked at the end, so a damaged record is reported (false) after it was sent
+  // Use verify first (then rewind the stream) if nothing should be drawn from a damaged file
+  static bool readRows(Stream &stream, QRCodeRowSink &sink, QRCodeFileHeader *header = NULL);
+
+  // Reads a record into a QR Code data buffer, qrcodegen_BUFFER_LEN_FOR_VERSION(version) bytes (false if too small)
+  static bool read(Stream &stream, uint8_t *qrcode, size_t bufferLength, QRCodeFileHeader *header = NULL);
+
+  // Reads a record and checks it, without using its rows
+  static bool verify(Stream &stream, QRCodeFileHeader *header = NULL);
+};
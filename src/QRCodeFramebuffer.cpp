@@ -0,0 +1,185 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeFramebuffer.h"
+
+// Expansion tables, indexed by the modules that fill one byte
+static const uint8_t EXPAND_BY_2[16] PROGMEM = {
+  0x00, 0x03, 0x0C, 0x0F, 0x30, 0x33, 0x3C, 0x3F, 0xC0, 0xC3, 0xCC, 0xCF, 0xF0, 0xF3, 0xFC, 0xFF
+};
+static const uint8_t EXPAND_BY_4[4] PROGMEM = {0x00, 0x0F, 0xF0, 0xFF};
+
+// Bit order of Pages bytes is the reverse of Rows bytes
+static const uint8_t REVERSE_NIBBLE[16] PROGMEM = {
+  0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+};
+
+static inline uint8_t reverseBits(uint8_t byte) {
+  return (pgm_read_byte(REVERSE_NIBBLE + (byte & 0x0F)) << 4) | pgm_read_byte(REVERSE_NIBBLE + (byte >> 4));
+}
+
+// Pixels [8 * index, 8 * index + 8) of the scaled modules, most significant bit first
+// Pixels past the last module are 0, they are always masked out
+static uint8_t expandedByte(const uint8_t *modules, uint8_t moduleCount, uint16_t scale, int32_t index) {
+  if (index < 0) {
+    return 0;
+  }
+
+  switch (scale) {
+    case 1:
+      return index < (moduleCount + 7) / 8 ? modules[index] : 0;
+    case 2:
+      if (index >= (moduleCount + 3) / 4) {
+        return 0;
+      }
+      return pgm_read_byte(EXPAND_BY_2 + ((modules[index >> 1] >> (index & 1 ? 0 : 4)) & 0x0F));
+    case 4:
+      if (index >= (moduleCount + 1) / 2) {
+        return 0;
+      }
+      return pgm_read_byte(EXPAND_BY_4 + ((modules[index >> 2] >> (6 - 2 * (index & 3))) & 0x03));
+    case 8:
+      if (index >= moduleCount) {
+        return 0;
+      }
+      return (modules[index >> 3] >> (7 - (index & 7))) & 1 ? 0xFF : 0x00;
+  }
+
+  // Other scales: one run of identical pixels per module in this byte
+  uint8_t byte = 0;
+  int32_t pixel = index * 8;
+  int32_t end = pixel + 8;
+  while (pixel < end) {
+    int32_t module = pixel / scale;
+    if (module >= moduleCount) {
+      break;
+    }
+    int32_t runEnd = (module + 1) * scale;
+    if (runEnd > end) {
+      runEnd = end;
+    }
+    if ((modules[module >> 3] >> (7 - (module & 7))) & 1) {
+      byte |= (uint8_t)(0xFF >> (pixel - index * 8)) & (uint8_t)~(0xFF >> (runEnd - index * 8));
+    }
+    pixel = runEnd;
+  }
+  return byte;
+}
+
+// Constructor
+
+QRCodeFramebuffer::QRCodeFramebuffer(uint8_t *buffer, int16_t width, int16_t height, QRCodeFramebufferLayout layout,
+                                     uint8_t bitOffset, uint16_t stride) {
+  this->buffer = buffer;
+  this->width = width;
+  this->height = height;
+  this->layout = layout;
+  this->bitOffset = bitOffset;
+  if (stride == 0) {
+    stride = layout == QRCodeFramebufferLayout::Rows ? (bitOffset + width + 7) / 8 : width;
+  }
+  this->stride = stride;
+  clearClip();
+}
+
+// Getters and setters
+
+QRCodeFramebuffer& QRCodeFramebuffer::setClip(int16_t x, int16_t y, int16_t width, int16_t height) {
+  clipX0 = x < 0 ? 0 : x;
+  clipY0 = y < 0 ? 0 : y;
+  clipX1 = x + width > this->width ? this->width : x + width;
+  clipY1 = y + height > this->height ? this->height : y + height;
+  return *this;
+}
+
+QRCodeFramebuffer& QRCodeFramebuffer::clearClip() {
+  return setClip(0, 0, width, height);
+}
+
+uint8_t* QRCodeFramebuffer::getBuffer() {
+  return buffer;
+}
+
+int16_t QRCodeFramebuffer::getWidth() {
+  return width;
+}
+
+int16_t QRCodeFramebuffer::getHeight() {
+  return height;
+}
+
+QRCodeFramebufferLayout QRCodeFramebuffer::getLayout() {
+  return layout;
+}
+
+uint16_t QRCodeFramebuffer::getStride() {
+  return stride;
+}
+
+uint8_t QRCodeFramebuffer::getBitOffset() {
+  return bitOffset;
+}
+
+// Writing methods
+
+void QRCodeFramebuffer::writeModules(int16_t line, int16_t position, const uint8_t *modules, uint8_t moduleCount, uint16_t scale) {
+  bool pages = layout == QRCodeFramebufferLayout::Pages;
+  int16_t lineMin = pages ? clipX0 : clipY0;
+  int16_t lineMax = pages ? clipX1 : clipY1;
+  int16_t positionMin = pages ? clipY0 : clipX0;
+  int16_t positionMax = pages ? clipY1 : clipX1;
+  if (line < lineMin || line >= lineMax) {
+    return;
+  }
+
+  // Pixels to write, as bit positions along the line
+  int32_t first = position > positionMin ? position : positionMin;
+  int32_t last = (int32_t)position + (int32_t)moduleCount * scale;
+  if (last > positionMax) {
+    last = positionMax;
+  }
+  if (first >= last) {
+    return;
+  }
+  int32_t base = bitOffset + (int32_t)position; // bit of the first module pixel
+  first += bitOffset;
+  last += bitOffset;
+
+  // Each buffer byte takes 8 pixels that straddle two expanded bytes, unless they are aligned
+  int32_t firstByte = first >> 3;
+  int32_t lastByte = (last - 1) >> 3;
+  int32_t source = firstByte * 8 - base;  // pixel of the scaled modules at the start of the first byte
+  uint8_t shift = source & 7;
+  int32_t index = source >> 3;             // arithmetic shift, the first index may be negative
+  uint8_t current = expandedByte(modules, moduleCount, scale, index);
+
+  for (int32_t byteIndex = firstByte; byteIndex <= lastByte; byteIndex++) {
+    uint8_t next = expandedByte(modules, moduleCount, scale, ++index);
+    uint8_t value = shift == 0 ? current : (uint8_t)((current << shift) | (next >> (8 - shift)));
+    current = next;
+
+    uint8_t mask = 0xFF;
+    if (byteIndex == firstByte) {
+      mask &= 0xFF >> (first & 7);
+    }
+    if (byteIndex == lastByte) {
+      mask &= (uint8_t)(0xFF << (7 - ((last - 1) & 7)));
+    }
+
+    uint8_t *destination;
+    if (pages) {
+      value = reverseBits(value);
+      mask = reverseBits(mask);
+      destination = buffer + (size_t)byteIndex * stride + line;
+    }
+    else {
+      destination = buffer + (size_t)line * stride + byteIndex;
+    }
+    *destination = (*destination & ~mask) | (value & mask);
+  }
+}
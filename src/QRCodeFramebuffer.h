@@ -0,0 +1,58 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+
+// How a monochrome display driver packs its pixels in memory
+enum class QRCodeFramebufferLayout {
+  Pages,  // SSD1306, SH1106...: each byte is a column of 8 pixels (bit 0 on top), a page of bytes per 8 rows
+  Rows    // GxEPD2, GFXcanvas1...: each byte is 8 pixels of a row (most significant bit on the left)
+};
+
+// A 1 bit per pixel buffer owned by a display driver (or by you), that QRCodeGFX can draw into directly
+// instead of calling drawPixel for every pixel. Set bits are drawn for non-zero colors, like Adafruit_GFX does
+//   QRCodeFramebuffer framebuffer(display.getBuffer(), 128, 64, QRCodeFramebufferLayout::Pages);
+//   qrcode.drawTo(framebuffer, x, y);
+//   display.display();
+class QRCodeFramebuffer {
+private:
+  uint8_t *buffer;
+  int16_t width;
+  int16_t height;
+  QRCodeFramebufferLayout layout;
+  uint16_t stride;
+  uint8_t bitOffset;
+  int16_t clipX0, clipY0, clipX1, clipY1;
+
+public:
+  // Constructor
+  // bitOffset is the bit where the first pixel of each line starts (a row for Rows, a column for Pages),
+  // for pixels that don't start on a byte boundary
+  // stride is the number of bytes from one row (Rows) or page (Pages) to the next, 0 if they are packed
+  QRCodeFramebuffer(uint8_t *buffer, int16_t width, int16_t height, QRCodeFramebufferLayout layout,
+                    uint8_t bitOffset = 0, uint16_t stride = 0);
+
+  // Getters and setters
+  // Pixels outside the clip rectangle (the whole buffer by default) are never written
+  QRCodeFramebuffer& setClip(int16_t x, int16_t y, int16_t width, int16_t height);
+  QRCodeFramebuffer& clearClip();
+  uint8_t* getBuffer();
+  int16_t getWidth();
+  int16_t getHeight();
+  QRCodeFramebufferLayout getLayout();
+  uint16_t getStride();
+  uint8_t getBitOffset();
+
+  // Writes moduleCount modules, scaled to scale pixels each, along one line of the buffer
+  // For Rows, line is y and position is x; for Pages, line is x and position is y
+  // modules holds the pixel value of each module, the first one in the most significant bit of modules[0]
+  // Bytes are expanded with lookup tables for scales 1, 2, 4 and 8, and built from runs for the others
+  void writeModules(int16_t line, int16_t position, const uint8_t *modules, uint8_t moduleCount, uint16_t scale);
+};
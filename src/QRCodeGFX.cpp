@@ -7,6 +7,9 @@ https://github.com/wallysalami/QRCodeGFX
 *************************************************/
 
 #include "QRCodeGFX.h"
+#include "QRCodeDisplayList.h"
+#include "QRCodeCompressed.h"
+#include "QRCodeFile.h"
 
 // Constructor
 
@@ -17,6 +20,7 @@ QRCodeGFX::QRCodeGFX(Adafruit_GFX& d): display(d) {
 
 QRCodeGFX::~QRCodeGFX() {
   releaseData();
+  releaseNext();
 }
 
 // Getters and setters
@@ -80,6 +84,12 @@ QRCodeGenerator& QRCodeGFX::getGenerator() {
   return generator;
 }
 
+#ifdef QRCODE_STATS
+const QRCodeStats& QRCodeGFX::getLastStats() {
+  return lastStats;
+}
+#endif
+
 // Drawing methods
 
 bool QRCodeGFX::draw(const String &text, int16_t x, int16_t y) {
@@ -95,39 +105,75 @@ bool QRCodeGFX::draw(const char* text, int16_t x, int16_t y) {
   return draw(x, y, true);
 }
 
+bool QRCodeGFX::draw(const __FlashStringHelper *text, int16_t x, int16_t y) {
+  bool success = generateData(text);
+  if (success == false) {
+    return false;
+  }
+
+  return draw(x, y, true);
+}
+
+bool QRCodeGFX::draw(const uint8_t *data, size_t length, int16_t x, int16_t y) {
+  bool success = generateData(data, length);
+  if (success == false) {
+    return false;
+  }
+
+  return draw(x, y, true);
+}
+
+bool QRCodeGFX::draw(const QRCodeStaticData &data, int16_t x, int16_t y) {
+  if (data.qrcode == NULL) {
+    return false;
+  }
+
+  drawModules(data.qrcode, true, x, y);
+
+  return true;
+}
+
 bool QRCodeGFX::draw(int16_t x, int16_t y, bool releaseQRCodeData) {
-  int16_t x0 = x, y0 = y;
-  int size = getSideLength();
-  if (size == 0) {
+  if (qrcodeBuffer == NULL) {
     return false; // error: qrcode not generated before calling draw
   }
+
+  drawModules(qrcodeBuffer, false, x, y);
+
+  if (releaseQRCodeData) {
+    releaseData();
+  }
+
+  return true;
+}
+
+void QRCodeGFX::drawModules(const uint8_t *qrcode, bool inFlash, int16_t x0, int16_t y0) {
+  QRCODE_STATS_DO(lastStats.displayCalls = 0);
+  QRCODE_STATS_DO(QRCodeStackProbe stackProbe);
+  QRCODE_STATS_DO(stackProbe.paint());
+  QRCODE_STATS_DO(uint32_t start = micros());
+
+  int qrcodeSize = inFlash ? pgm_read_byte(qrcode) : qrcode[0];
+  int size = getSideLength(qrcodeSize);
   display.fillRect(x0, y0, size, size, backgroundColor);
+  QRCODE_STATS_DO(lastStats.displayCalls++);
 
+  drawModuleRows(qrcode, inFlash, x0, y0, 0, qrcodeSize);
+
+  QRCODE_STATS_DO(lastStats.drawMicros = micros() - start);
+  QRCODE_STATS_DO(lastStats.drawStackBytes = stackProbe.measure());
+  QRCODE_STATS_DO(lastStats.drawStackCapped = stackProbe.isCapped());
+}
+
+void QRCodeGFX::drawModuleRows(const uint8_t *qrcode, bool inFlash, int16_t x0, int16_t y0, uint8_t firstRow, uint8_t lastRow) {
+  int qrcodeSize = inFlash ? pgm_read_byte(qrcode) : qrcode[0];
   int padding = scale * 3;
 
-  int qrcodeSize = qrcodegen_getSize(qrcodeBuffer);
-  for (uint8_t i = 0; i < qrcodeSize; i++) {
-    for (uint8_t j = 0; j < qrcodeSize; j++) {
-      int x, y;
-      switch(rotation) {
-        case QRCodeRotation::R0:
-          x = x0 + padding + scale * j;
-          y = y0 + padding + scale * i;
-          break;
-        case QRCodeRotation::R90:
-          x = x0 + padding + scale * (qrcodeSize - i - 1);
-          y = y0 + padding + scale * j;
-          break;
-        case QRCodeRotation::R180:
-          x = x0 + padding + scale * (qrcodeSize - j - 1);
-          y = y0 + padding + scale * (qrcodeSize - i - 1);
-          break;
-        case QRCodeRotation::R270:
-          x = x0 + padding + scale * i;
-          y = y0 + padding + scale * (qrcodeSize - j - 1);
-          break;
-      }
-      uint16_t color = qrcodegen_getModule(qrcodeBuffer, j, i) ? foregroundColor : backgroundColor;
+  for (uint8_t row = firstRow; row < lastRow; row++) {
+    int y = y0 + padding + scale * row;
+    for (uint8_t column = 0; column < qrcodeSize; column++) {
+      int x = x0 + padding + scale * column;
+      uint16_t color = isDarkOnScreen(qrcode, inFlash, qrcodeSize, row, column) ? foregroundColor : backgroundColor;
       if (scale == 1) {
         display.drawPixel(x, y, color);
       }
@@ -135,8 +181,46 @@ bool QRCodeGFX::draw(int16_t x, int16_t y, bool releaseQRCodeData) {
         display.fillRect(x, y, scale, scale, color);
       }
     }
+    QRCODE_STATS_DO(lastStats.displayCalls += qrcodeSize);
+  }
+}
+
+bool QRCodeGFX::isDarkOnScreen(const uint8_t *qrcode, bool inFlash, int qrcodeSize, int row, int column) {
+  // row and column are on screen, i and j are the module coordinates for the current rotation
+  int i, j;
+  switch(rotation) {
+    case QRCodeRotation::R0:
+      i = row;
+      j = column;
+      break;
+    case QRCodeRotation::R90:
+      i = qrcodeSize - column - 1;
+      j = row;
+      break;
+    case QRCodeRotation::R180:
+      i = qrcodeSize - row - 1;
+      j = qrcodeSize - column - 1;
+      break;
+    default: // R270
+      i = column;
+      j = qrcodeSize - row - 1;
+      break;
+  }
+  // Same bit layout as qrcodegen_getModule, which can't read from flash
+  int index = i * qrcodeSize + j;
+  uint8_t modules = inFlash ? pgm_read_byte(qrcode + (index >> 3) + 1) : qrcode[(index >> 3) + 1];
+  return (modules >> (index & 7)) & 1;
+}
+
+// Framebuffer drawing methods
+
+bool QRCodeGFX::drawTo(QRCodeFramebuffer &framebuffer, int16_t x, int16_t y, bool releaseQRCodeData) {
+  if (qrcodeBuffer == NULL) {
+    return false; // error: qrcode not generated before calling drawTo
   }
 
+  drawModulesTo(qrcodeBuffer, false, framebuffer, x, y);
+
   if (releaseQRCodeData) {
     releaseData();
   }
@@ -144,6 +228,427 @@ bool QRCodeGFX::draw(int16_t x, int16_t y, bool releaseQRCodeData) {
   return true;
 }
 
+bool QRCodeGFX::drawTo(const QRCodeStaticData &data, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y) {
+  if (data.qrcode == NULL) {
+    return false;
+  }
+
+  drawModulesTo(data.qrcode, true, framebuffer, x, y);
+
+  return true;
+}
+
+void QRCodeGFX::drawModulesTo(const uint8_t *qrcode, bool inFlash, QRCodeFramebuffer &framebuffer, int16_t x0, int16_t y0) {
+  QRCODE_STATS_DO(lastStats.displayCalls = 0);
+  QRCODE_STATS_DO(uint32_t start = micros());
+
+  int qrcodeSize = inFlash ? pgm_read_byte(qrcode) : qrcode[0];
+  int size = getSideLength(qrcodeSize);
+  uint8_t moduleCount = qrcodeSize + 6; // with the quiet zone
+  bool foreground = foregroundColor != 0;
+  bool background = backgroundColor != 0;
+
+  // The buffer is written one line at a time: a row of pixels for Rows, a column for Pages
+  // All the lines of a module line are the same, so the module line is only built once for them
+  bool pages = framebuffer.getLayout() == QRCodeFramebufferLayout::Pages;
+  int16_t firstLine = pages ? x0 : y0;
+  int16_t position = pages ? y0 : x0;
+  uint8_t modules[(qrcodegen_VERSION_MAX * 4 + 17 + 6 + 7) / 8];
+  int builtModuleLine = -1;
+
+  for (int pixel = 0; pixel < size; pixel++) {
+    int moduleLine = pixel / scale;
+    if (moduleLine != builtModuleLine) {
+      memset(modules, 0, sizeof(modules));
+      for (uint8_t module = 0; module < moduleCount; module++) {
+        int row = (pages ? module : moduleLine) - 3;
+        int column = (pages ? moduleLine : module) - 3;
+        bool inside = row >= 0 && row < qrcodeSize && column >= 0 && column < qrcodeSize;
+        if ((inside && isDarkOnScreen(qrcode, inFlash, qrcodeSize, row, column)) ? foreground : background) {
+          modules[module >> 3] |= 0x80 >> (module & 7);
+        }
+      }
+      builtModuleLine = moduleLine;
+    }
+    framebuffer.writeModules(firstLine + pixel, position, modules, moduleCount, scale);
+  }
+
+  QRCODE_STATS_DO(lastStats.drawMicros = micros() - start);
+}
+
+// Display list methods
+
+bool QRCodeGFX::buildDisplayList(QRCodeDisplayList &list, bool releaseQRCodeData) {
+  if (qrcodeBuffer == NULL) {
+    return false; // error: qrcode not generated before calling buildDisplayList
+  }
+
+  if (!list.build(qrcodeBuffer)) {
+    return false; // error: not enough memory, the data is kept
+  }
+
+  if (releaseQRCodeData) {
+    releaseData();
+  }
+
+  return true;
+}
+
+bool QRCodeGFX::draw(const QRCodeDisplayList &list, int16_t x, int16_t y) {
+  if (list.isEmpty()) {
+    return false;
+  }
+
+  QRCODE_STATS_DO(QRCodeStackProbe stackProbe);
+  QRCODE_STATS_DO(stackProbe.paint());
+  QRCODE_STATS_DO(uint32_t start = micros());
+
+  list.replay(display, x, y, scale, rotation, backgroundColor, foregroundColor);
+
+  QRCODE_STATS_DO(lastStats.displayCalls = list.getRectCount() + 1);
+  QRCODE_STATS_DO(lastStats.drawMicros = micros() - start);
+  QRCODE_STATS_DO(lastStats.drawStackBytes = stackProbe.measure());
+  QRCODE_STATS_DO(lastStats.drawStackCapped = stackProbe.isCapped());
+
+  return true;
+}
+
+// Fused drawing methods
+// The generator streams the rows as it masks them, the sinks below place them on screen
+
+// Where a symbol row lands on screen: a row (R0, R180) or a column (R90, R270), in order or reversed
+struct QRCodeScreenLine {
+  bool horizontal;
+  bool reversed;
+  uint8_t index;
+
+  QRCodeScreenLine(QRCodeRotation rotation, uint8_t y, uint8_t size) {
+    horizontal = rotation == QRCodeRotation::R0 || rotation == QRCodeRotation::R180;
+    reversed = rotation == QRCodeRotation::R180 || rotation == QRCodeRotation::R270;
+    index = rotation == QRCodeRotation::R0 || rotation == QRCodeRotation::R270 ? y : size - 1 - y;
+  }
+};
+
+static bool getRowModule(const uint8_t *modules, uint8_t index) {
+  return (modules[index >> 3] >> (7 - (index & 7))) & 1;
+}
+
+class QRCodeDisplayRowSink : public QRCodeRowSink {
+private:
+  Adafruit_GFX &display;
+  QRCodeGFX &qrcode;
+  int16_t x0, y0;
+
+public:
+  uint32_t displayCalls = 0;
+
+  QRCodeDisplayRowSink(Adafruit_GFX &display, QRCodeGFX &qrcode, int16_t x, int16_t y)
+    : display(display), qrcode(qrcode), x0(x), y0(y) {
+  }
+
+  void begin(uint8_t size) override {
+    int scale = qrcode.getScale();
+    int side = (size + 6) * scale;
+    int padding = scale * 3;
+    uint16_t color = qrcode.getBackgroundColor();
+    display.fillRect(x0, y0, side, padding, color);
+    display.fillRect(x0, y0 + side - padding, side, padding, color);
+    display.fillRect(x0, y0 + padding, padding, side - 2 * padding, color);
+    display.fillRect(x0 + side - padding, y0 + padding, padding, side - 2 * padding, color);
+    displayCalls += 4;
+  }
+
+  void writeRow(uint8_t y, const uint8_t *modules, uint8_t size) override {
+    QRCodeScreenLine line(qrcode.getRotation(), y, size);
+    int scale = qrcode.getScale();
+    int padding = scale * 3;
+
+    // One rectangle per run of modules of the same color
+    uint8_t runStart = 0;
+    for (uint8_t t = 1; t <= size; t++) {
+      bool dark = getRowModule(modules, line.reversed ? size - 1 - runStart : runStart);
+      if (t < size && getRowModule(modules, line.reversed ? size - 1 - t : t) == dark) {
+        continue;
+      }
+      uint16_t color = dark ? qrcode.getForegroundColor() : qrcode.getBackgroundColor();
+      int along = padding + runStart * scale;
+      int across = padding + line.index * scale;
+      int length = (t - runStart) * scale;
+      if (line.horizontal) {
+        display.fillRect(x0 + along, y0 + across, length, scale, color);
+      }
+      else {
+        display.fillRect(x0 + across, y0 + along, scale, length, color);
+      }
+      displayCalls++;
+      runStart = t;
+    }
+  }
+};
+
+class QRCodeFramebufferRowSink : public QRCodeRowSink {
+private:
+  QRCodeFramebuffer &framebuffer;
+  QRCodeGFX &qrcode;
+  int16_t firstLine, position; // see QRCodeFramebuffer::writeModules
+
+public:
+  QRCodeFramebufferRowSink(QRCodeFramebuffer &framebuffer, QRCodeGFX &qrcode, int16_t x, int16_t y)
+    : framebuffer(framebuffer), qrcode(qrcode) {
+    bool pages = framebuffer.getLayout() == QRCodeFramebufferLayout::Pages;
+    firstLine = pages ? x : y;
+    position = pages ? y : x;
+  }
+
+  void begin(uint8_t size) override {
+    uint16_t scale = qrcode.getScale();
+    int side = (size + 6) * scale;
+    int padding = scale * 3;
+    uint8_t background[(qrcodegen_VERSION_MAX * 4 + 17 + 6 + 7) / 8];
+    memset(background, qrcode.getBackgroundColor() != 0 ? 0xFF : 0x00, sizeof(background));
+
+    for (int pixel = 0; pixel < side; pixel++) {
+      if (pixel < padding || pixel >= side - padding) {
+        framebuffer.writeModules(firstLine + pixel, position, background, size + 6, scale);
+      }
+      else {
+        framebuffer.writeModules(firstLine + pixel, position, background, 3, scale);
+        framebuffer.writeModules(firstLine + pixel, position + side - padding, background, 3, scale);
+      }
+    }
+  }
+
+  void writeRow(uint8_t y, const uint8_t *modules, uint8_t size) override {
+    QRCodeScreenLine line(qrcode.getRotation(), y, size);
+    uint16_t scale = qrcode.getScale();
+    int padding = scale * 3;
+    bool foreground = qrcode.getForegroundColor() != 0;
+    bool background = qrcode.getBackgroundColor() != 0;
+
+    // Pixel values in screen order
+    uint8_t pixels[(qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8];
+    memset(pixels, 0, sizeof(pixels));
+    for (uint8_t t = 0; t < size; t++) {
+      if (getRowModule(modules, line.reversed ? size - 1 - t : t) ? foreground : background) {
+        pixels[t >> 3] |= 0x80 >> (t & 7);
+      }
+    }
+
+    bool pages = framebuffer.getLayout() == QRCodeFramebufferLayout::Pages;
+    if (line.horizontal != pages) {
+      // The row runs along the buffer lines: one write per line of pixels
+      for (uint16_t k = 0; k < scale; k++) {
+        framebuffer.writeModules(firstLine + padding + line.index * scale + k, position + padding, pixels, size, scale);
+      }
+    }
+    else {
+      // The row runs across the buffer lines: one module per line
+      for (uint8_t t = 0; t < size; t++) {
+        uint8_t pixel = getRowModule(pixels, t) ? 0x80 : 0x00;
+        for (uint16_t k = 0; k < scale; k++) {
+          framebuffer.writeModules(firstLine + padding + t * scale + k, position + padding + line.index * scale, &pixel, 1, scale);
+        }
+      }
+    }
+  }
+};
+
+bool QRCodeGFX::drawDirect(const String &text, int16_t x, int16_t y) {
+  return drawDirect(text.c_str(), x, y);
+}
+
+bool QRCodeGFX::drawDirect(const char *text, int16_t x, int16_t y) {
+  releaseData();
+  useFreeBuffer(nextQRCodeBuffer);
+  QRCODE_STATS_DO(QRCodeStackProbe stackProbe);
+  QRCODE_STATS_DO(stackProbe.paint());
+  QRCODE_STATS_DO(uint32_t start = micros());
+
+  QRCodeDisplayRowSink sink(display, *this, x, y);
+  bool success = generator.generateRows(text, sink);
+
+  // Generation and drawing are interleaved, so the drawing numbers cover the whole call
+  QRCODE_STATS_DO(lastStats = generator.getLastStats());
+  QRCODE_STATS_DO(lastStats.displayCalls = sink.displayCalls);
+  QRCODE_STATS_DO(lastStats.drawMicros = micros() - start);
+  QRCODE_STATS_DO(lastStats.drawStackBytes = stackProbe.measure());
+  QRCODE_STATS_DO(lastStats.drawStackCapped = stackProbe.isCapped());
+
+  return success;
+}
+
+bool QRCodeGFX::drawDirect(const String &text, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y) {
+  return drawDirect(text.c_str(), framebuffer, x, y);
+}
+
+bool QRCodeGFX::drawDirect(const char *text, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y) {
+  releaseData();
+  useFreeBuffer(nextQRCodeBuffer);
+  QRCODE_STATS_DO(QRCodeStackProbe stackProbe);
+  QRCODE_STATS_DO(stackProbe.paint());
+  QRCODE_STATS_DO(uint32_t start = micros());
+
+  QRCodeFramebufferRowSink sink(framebuffer, *this, x, y);
+  bool success = generator.generateRows(text, sink);
+
+  // Generation and drawing are interleaved, so the drawing numbers cover the whole call
+  QRCODE_STATS_DO(lastStats = generator.getLastStats());
+  QRCODE_STATS_DO(lastStats.displayCalls = 0);
+  QRCODE_STATS_DO(lastStats.drawMicros = micros() - start);
+  QRCODE_STATS_DO(lastStats.drawStackBytes = stackProbe.measure());
+  QRCODE_STATS_DO(lastStats.drawStackCapped = stackProbe.isCapped());
+
+  return success;
+}
+
+// Compressed drawing methods
+// The rows are rebuilt one at a time and go through the same sinks as drawDirect
+
+bool QRCodeGFX::compressData(QRCodeCompressed &compressed, bool releaseQRCodeData) {
+  if (qrcodeBuffer == NULL) {
+    return false; // error: qrcode not generated before calling compressData
+  }
+
+  if (!compressed.compress(qrcodeBuffer)) {
+    return false; // error: not enough memory, the data is kept
+  }
+
+  if (releaseQRCodeData) {
+    releaseData();
+  }
+
+  return true;
+}
+
+bool QRCodeGFX::draw(const QRCodeCompressed &compressed, int16_t x, int16_t y) {
+  QRCODE_STATS_DO(QRCodeStackProbe stackProbe);
+  QRCODE_STATS_DO(stackProbe.paint());
+  QRCODE_STATS_DO(uint32_t start = micros());
+
+  QRCodeDisplayRowSink sink(display, *this, x, y);
+  if (!compressed.writeRows(sink)) {
+    return false;
+  }
+
+  QRCODE_STATS_DO(lastStats.displayCalls = sink.displayCalls);
+  QRCODE_STATS_DO(lastStats.drawMicros = micros() - start);
+  QRCODE_STATS_DO(lastStats.drawStackBytes = stackProbe.measure());
+  QRCODE_STATS_DO(lastStats.drawStackCapped = stackProbe.isCapped());
+
+  return true;
+}
+
+bool QRCodeGFX::drawTo(const QRCodeCompressed &compressed, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y) {
+  QRCodeFramebufferRowSink sink(framebuffer, *this, x, y);
+  return compressed.writeRows(sink);
+}
+
+// File drawing methods
+// Same sinks again, fed by the rows of a QRCodeFile record
+
+bool QRCodeGFX::drawFrom(Stream &stream, int16_t x, int16_t y) {
+  QRCODE_STATS_DO(QRCodeStackProbe stackProbe);
+  QRCODE_STATS_DO(stackProbe.paint());
+  QRCODE_STATS_DO(uint32_t start = micros());
+
+  QRCodeDisplayRowSink sink(display, *this, x, y);
+  if (!QRCodeFile::readRows(stream, sink)) {
+    return false; // error: damaged or truncated record
+  }
+
+  QRCODE_STATS_DO(lastStats.displayCalls = sink.displayCalls);
+  QRCODE_STATS_DO(lastStats.drawMicros = micros() - start);
+  QRCODE_STATS_DO(lastStats.drawStackBytes = stackProbe.measure());
+  QRCODE_STATS_DO(lastStats.drawStackCapped = stackProbe.isCapped());
+
+  return true;
+}
+
+bool QRCodeGFX::drawFrom(Stream &stream, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y) {
+  QRCodeFramebufferRowSink sink(framebuffer, *this, x, y);
+  return QRCodeFile::readRows(stream, sink);
+}
+
+// Incremental drawing methods
+
+bool QRCodeGFX::beginDraw(int16_t x, int16_t y, bool releaseQRCodeData) {
+  if (qrcodeBuffer == NULL) {
+    rowCount = nextRow = 0;
+    return false; // error: qrcode not generated before calling beginDraw
+  }
+
+  drawX = x;
+  drawY = y;
+  nextRow = 0;
+  rowCount = qrcodegen_getSize(qrcodeBuffer);
+  releaseAfterDraw = releaseQRCodeData;
+  QRCODE_STATS_DO(lastStats.drawMicros = 0);
+  QRCODE_STATS_DO(lastStats.displayCalls = 0);
+  QRCODE_STATS_DO(lastStats.drawStackBytes = 0);
+  QRCODE_STATS_DO(lastStats.drawStackCapped = false);
+
+  return true;
+}
+
+bool QRCodeGFX::drawStep(uint32_t budgetMicros) {
+  uint32_t start = micros();
+  while (!isDrawComplete()) {
+    drawRowSlice(1);
+    if (micros() - start >= budgetMicros) {
+      break;
+    }
+  }
+
+  return isDrawComplete();
+}
+
+bool QRCodeGFX::drawRows(uint8_t count) {
+  if (!isDrawComplete()) {
+    drawRowSlice(count > 0 ? count : 1);
+  }
+
+  return isDrawComplete();
+}
+
+bool QRCodeGFX::isDrawComplete() {
+  return nextRow >= rowCount;
+}
+
+void QRCodeGFX::drawRowSlice(uint8_t count) {
+  QRCODE_STATS_DO(QRCodeStackProbe stackProbe);
+  QRCODE_STATS_DO(stackProbe.paint());
+  QRCODE_STATS_DO(uint32_t start = micros());
+  uint8_t lastRow = count < rowCount - nextRow ? nextRow + count : rowCount;
+  int size = getSideLength(rowCount);
+  int padding = scale * 3;
+
+  // The quiet zone is drawn along with the rows it borders, instead of filling the whole square first
+  if (nextRow == 0) {
+    display.fillRect(drawX, drawY, size, padding, backgroundColor);
+    QRCODE_STATS_DO(lastStats.displayCalls++);
+  }
+  int y = drawY + padding + scale * nextRow;
+  int height = scale * (lastRow - nextRow);
+  display.fillRect(drawX, y, padding, height, backgroundColor);
+  display.fillRect(drawX + size - padding, y, padding, height, backgroundColor);
+  QRCODE_STATS_DO(lastStats.displayCalls += 2);
+  if (lastRow == rowCount) {
+    display.fillRect(drawX, drawY + size - padding, size, padding, backgroundColor);
+    QRCODE_STATS_DO(lastStats.displayCalls++);
+  }
+
+  drawModuleRows(qrcodeBuffer, false, drawX, drawY, nextRow, lastRow);
+  nextRow = lastRow;
+  QRCODE_STATS_DO(lastStats.drawMicros += micros() - start);
+  QRCODE_STATS_DO(uint32_t stackBytes = stackProbe.measure());
+  QRCODE_STATS_DO(if (stackBytes > lastStats.drawStackBytes) lastStats.drawStackBytes = stackBytes);
+  QRCODE_STATS_DO(if (stackProbe.isCapped()) lastStats.drawStackCapped = true);
+
+  if (isDrawComplete() && releaseAfterDraw) {
+    releaseData();
+  }
+}
+
 // Generation methods
 
 bool QRCodeGFX::generateData(const String &text) {
@@ -152,22 +657,239 @@ bool QRCodeGFX::generateData(const String &text) {
 
 bool QRCodeGFX::generateData(const char *text) {
   releaseData();
+  useFreeBuffer(nextQRCodeBuffer);
 
   qrcodeBuffer = generator.generateData(text);
+  QRCODE_STATS_DO(lastStats = generator.getLastStats());
+
+  return qrcodeBuffer != NULL;
+}
+
+bool QRCodeGFX::generateData(const __FlashStringHelper *text) {
+  releaseData();
+  useFreeBuffer(nextQRCodeBuffer);
+
+  qrcodeBuffer = generator.generateData(text);
+  QRCODE_STATS_DO(lastStats = generator.getLastStats());
+
+  return qrcodeBuffer != NULL;
+}
+
+bool QRCodeGFX::generateData(const uint8_t *data, size_t length) {
+  releaseData();
+  useFreeBuffer(nextQRCodeBuffer);
+
+  qrcodeBuffer = generator.generateData(data, length);
+  QRCODE_STATS_DO(lastStats = generator.getLastStats());
+
+  return qrcodeBuffer != NULL;
+}
+
+QRCodePayloadWriter& QRCodeGFX::beginPayload(size_t maxLength) {
+  releaseData();
+  useFreeBuffer(nextQRCodeBuffer);
+
+  return generator.beginPayload(maxLength);
+}
+
+bool QRCodeGFX::endPayload() {
+  qrcodeBuffer = generator.endPayload();
+  QRCODE_STATS_DO(lastStats = generator.getLastStats());
+
+  return qrcodeBuffer != NULL;
+}
+
+bool QRCodeGFX::generateFrom(Stream &stream, char terminator, size_t maxLength) {
+  releaseData();
+  useFreeBuffer(nextQRCodeBuffer);
+
+  qrcodeBuffer = generator.generateFrom(stream, terminator, maxLength);
+  QRCODE_STATS_DO(lastStats = generator.getLastStats());
 
   return qrcodeBuffer != NULL;
 }
 
+bool QRCodeGFX::beginGenerate(const String &text) {
+  return beginGenerate(text.c_str());
+}
+
+bool QRCodeGFX::beginGenerate(const char *text) {
+  releaseData();
+  useFreeBuffer(nextQRCodeBuffer);
+
+  return generator.beginGenerate(text);
+}
+
+uint8_t QRCodeGFX::step(uint32_t budgetMicros) {
+  if (!generator.isGenerating()) {
+    return 100;
+  }
+
+  uint8_t progress = generator.step(budgetMicros);
+  if (progress == 100) {
+    qrcodeBuffer = generator.endGenerate();
+  }
+
+  return progress;
+}
+
+bool QRCodeGFX::isGenerating() {
+  return generator.isGenerating();
+}
+
+bool QRCodeGFX::generateAsync(const String &text, QRCodeExecutor &executor, QRCodeCallback callback, void *context) {
+  return generateAsync(text.c_str(), executor, callback, context);
+}
+
+bool QRCodeGFX::generateAsync(const char *text, QRCodeExecutor &executor, QRCodeCallback callback, void *context) {
+  releaseData();
+  useFreeBuffer(nextQRCodeBuffer);
+
+  asyncCallback = callback;
+  asyncContext = context;
+#ifdef QRCODE_THREAD_POOL_ENABLED
+  asyncReady.store(false, std::memory_order_relaxed); // submitting the job publishes it to the executor
+#else
+  asyncReady = false;
+#endif
+  return generator.generateAsync(text, executor, onGeneratedAsync, this);
+}
+
+bool QRCodeGFX::isAsyncReady() {
+#ifdef QRCODE_THREAD_POOL_ENABLED
+  return asyncReady.exchange(false, std::memory_order_acquire);
+#else
+  bool ready = asyncReady;
+  asyncReady = false;
+  return ready;
+#endif
+}
+
+void QRCodeGFX::onGeneratedAsync(uint8_t *qrcode, void *context) {
+  QRCodeGFX *qrcodeGFX = (QRCodeGFX *)context;
+  qrcodeGFX->qrcodeBuffer = qrcode;
+  if (qrcodeGFX->asyncCallback != NULL) {
+    qrcodeGFX->asyncCallback(qrcode, qrcodeGFX->asyncContext);
+  }
+  // Last access to this object from the executor's thread: everything above is visible after isAsyncReady()
+#ifdef QRCODE_THREAD_POOL_ENABLED
+  qrcodeGFX->asyncReady.store(true, std::memory_order_release);
+#else
+  qrcodeGFX->asyncReady = true;
+#endif
+}
+
+// Double buffering methods
+
+QRCodeGFX& QRCodeGFX::setNextBuffer(uint8_t *buffer) {
+  nextStaticBuffer = buffer;
+  return *this;
+}
+
+bool QRCodeGFX::prepareNext(const String &text) {
+  return prepareNext(text.c_str());
+}
+
+bool QRCodeGFX::prepareNext(const char *text) {
+  if (!useFreeBuffer(qrcodeBuffer)) {
+    return false; // error: the only static buffer holds the current QR Code
+  }
+  releaseNext();
+  nextQRCodeBuffer = generator.generateData(text);
+
+  return nextQRCodeBuffer != NULL;
+}
+
+bool QRCodeGFX::prepareNext(const __FlashStringHelper *text) {
+  if (!useFreeBuffer(qrcodeBuffer)) {
+    return false; // error: the only static buffer holds the current QR Code
+  }
+  releaseNext();
+  nextQRCodeBuffer = generator.generateData(text);
+
+  return nextQRCodeBuffer != NULL;
+}
+
+bool QRCodeGFX::prepareNext(const uint8_t *data, size_t length) {
+  if (!useFreeBuffer(qrcodeBuffer)) {
+    return false; // error: the only static buffer holds the current QR Code
+  }
+  releaseNext();
+  nextQRCodeBuffer = generator.generateData(data, length);
+
+  return nextQRCodeBuffer != NULL;
+}
+
+bool QRCodeGFX::hasNext() {
+  return nextQRCodeBuffer != NULL;
+}
+
+void QRCodeGFX::swap() {
+  uint8_t *buffer = qrcodeBuffer;
+  qrcodeBuffer = nextQRCodeBuffer;
+  nextQRCodeBuffer = buffer;
+
+  rowCount = nextRow = 0; // a drawing in progress was showing the other QR Code
+}
+
+void QRCodeGFX::releaseNext() {
+  if (generator.getQRCodeBuffer() == NULL && nextQRCodeBuffer != NULL) {
+    free(nextQRCodeBuffer);
+  }
+
+  nextQRCodeBuffer = NULL;
+}
+
+bool QRCodeGFX::useFreeBuffer(const uint8_t *busyBuffer) {
+  uint8_t *staticBuffer = generator.getQRCodeBuffer();
+  if (staticBuffer == NULL || busyBuffer != staticBuffer) {
+    return true; // a new buffer is allocated for every QR Code, or the static one is free
+  }
+
+  if (nextStaticBuffer == NULL) {
+    // Only one static buffer: the QR Code in it can't be kept
+    if (busyBuffer == nextQRCodeBuffer) {
+      nextQRCodeBuffer = NULL;
+    }
+    return false;
+  }
+
+  // Generate into the other static buffer
+  generator.setBuffers(nextStaticBuffer, generator.getTempBuffer(), generator.getBufferSize());
+  nextStaticBuffer = staticBuffer;
+  return true;
+}
+
 int16_t QRCodeGFX::getSideLength() {
   if (qrcodeBuffer == NULL) {
     return 0;
   }
-  uint8_t size = qrcodegen_getSize(qrcodeBuffer);
+  return getSideLength(qrcodegen_getSize(qrcodeBuffer));
+}
+
+int16_t QRCodeGFX::getSideLength(const QRCodeStaticData &data) {
+  if (data.qrcode == NULL) {
+    return 0;
+  }
+  return getSideLength(pgm_read_byte(data.qrcode));
+}
+
+int16_t QRCodeGFX::getSideLength(const QRCodeCompressed &compressed) {
+  if (compressed.isEmpty()) {
+    return 0;
+  }
+  return getSideLength(compressed.getSize());
+}
+
+int16_t QRCodeGFX::getSideLength(uint8_t qrcodeSize) {
   int padding = scale * 3;
-  return size * scale + 2 * padding;
+  return qrcodeSize * scale + 2 * padding;
 }
 
 void QRCodeGFX::releaseData() {
+  generator.cancelGenerate();
+  rowCount = nextRow = 0;
+
   if (generator.getQRCodeBuffer() == NULL && qrcodeBuffer != NULL) {
     free(qrcodeBuffer);
   }
@@ -11,13 +11,16 @@ https://github.com/wallysalami/QRCodeGFX
 #include <Arduino.h>
 #include <Adafruit_GFX.h>
 #include "QRCodeGenerator.h"
+#include "QRCodeStatic.h"
+#include "QRCodeFramebuffer.h"
+#include "QRCodeModules.h"
 
-enum class QRCodeRotation {
-    R0 = 0,    // 0 degrees
-    R90 = 1,   // 90 degrees
-    R180 = 2,  // 180 degrees
-    R270 = 3   // 270 degrees
-};
+#ifdef QRCODE_THREAD_POOL_ENABLED
+#include <atomic>
+#endif
+
+class QRCodeDisplayList;
+class QRCodeCompressed;
 
 class QRCodeGFX {
 private:
@@ -29,6 +32,42 @@ private:
   QRCodeGenerator generator;
   uint8_t *qrcodeBuffer = NULL;
 
+  // Back buffer for double buffering, see prepareNext()
+  uint8_t *nextQRCodeBuffer = NULL;
+  uint8_t *nextStaticBuffer = NULL;
+
+  // Drawing started by beginDraw() (nextRow == rowCount when there is none)
+  int16_t drawX = 0;
+  int16_t drawY = 0;
+  uint8_t nextRow = 0;
+  uint8_t rowCount = 0;
+  bool releaseAfterDraw = false;
+
+#ifdef QRCODE_STATS
+  QRCodeStats lastStats = {};
+#endif
+
+  // Callback of the generation started by generateAsync()
+  QRCodeCallback asyncCallback = NULL;
+  void *asyncContext = NULL;
+
+  // Set by the executor's thread when the generation started by generateAsync() is done, see isAsyncReady()
+  // The release store and acquire load make the data written on that thread visible to the caller's thread
+#ifdef QRCODE_THREAD_POOL_ENABLED
+  std::atomic<bool> asyncReady{false};
+#else
+  bool asyncReady = false; // executors run the encoding on the calling thread
+#endif
+
+  int16_t getSideLength(uint8_t qrcodeSize);
+  void drawModules(const uint8_t *qrcode, bool inFlash, int16_t x, int16_t y);
+  void drawModuleRows(const uint8_t *qrcode, bool inFlash, int16_t x, int16_t y, uint8_t firstRow, uint8_t lastRow);
+  void drawRowSlice(uint8_t count);
+  bool isDarkOnScreen(const uint8_t *qrcode, bool inFlash, int qrcodeSize, int row, int column);
+  void drawModulesTo(const uint8_t *qrcode, bool inFlash, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y);
+  static void onGeneratedAsync(uint8_t *qrcode, void *context);
+  bool useFreeBuffer(const uint8_t *busyBuffer);
+
 public:
   // Constructor
   QRCodeGFX(Adafruit_GFX& d);
@@ -51,15 +90,71 @@ public:
 
   QRCodeGenerator& getGenerator();
 
+#ifdef QRCODE_STATS
+  // Stats of the last generation and drawing (only available when QRCODE_STATS is defined in qrcodegen.h)
+  const QRCodeStats& getLastStats();
+#endif
+
   // Drawing methods that handle everything
   bool draw(const String &text, int16_t x, int16_t y);
   bool draw(const char *text, int16_t x, int16_t y);
+  bool draw(const __FlashStringHelper *text, int16_t x, int16_t y);
+  bool draw(const uint8_t *data, size_t length, int16_t x, int16_t y);
+
+  // Draws a QR Code encoded at compile time (see QRCODE_STATIC), straight from flash
+  // It doesn't touch the generated data, so it can be interleaved with the other methods
+  bool draw(const QRCodeStaticData &data, int16_t x, int16_t y);
+  int16_t getSideLength(const QRCodeStaticData &data);
   
   // You can also use these methods to generate the QRCode data and draw it later
   bool generateData(const String &text);
   bool generateData(const char *text);
+  bool generateData(const __FlashStringHelper *text);
+  bool generateData(const uint8_t *data, size_t length);
   void releaseData();
 
+  // Incremental generation, see QRCodeGenerator for details
+  QRCodePayloadWriter& beginPayload(size_t maxLength);
+  bool endPayload();
+  bool generateFrom(Stream &stream, char terminator, size_t maxLength);
+
+  // Time-sliced generation, see QRCodeGenerator for details
+  // Call step in loop() until it returns 100, then the data is ready to draw
+  //   if (qrcode.step(2000) == 100) qrcode.draw(x, y);
+  bool beginGenerate(const String &text);
+  bool beginGenerate(const char *text);
+  uint8_t step(uint32_t budgetMicros);
+  bool isGenerating();
+
+  // Generation on an executor, see QRCodeGenerator for details
+  // When callback runs (on the executor's thread), the data is already stored here and ready to draw
+  // It receives the data pointer (NULL on failure) but the data is still owned by this object, don't free it
+  // Don't use this object from another thread until isAsyncReady() returns true, callback can be NULL then
+  //   qrcode.generateAsync(text, background, NULL);
+  //   ...
+  //   if (qrcode.isAsyncReady()) qrcode.draw(x, y);
+  bool generateAsync(const String &text, QRCodeExecutor &executor, QRCodeCallback callback, void *context = NULL);
+  bool generateAsync(const char *text, QRCodeExecutor &executor, QRCodeCallback callback, void *context = NULL);
+
+  // Returns true once, on the first call after the generation started by generateAsync() is done (and its callback
+  // returned), then false until the next one. After it returns true, the data is safe to use on the calling thread
+  // A flag set by the callback is not enough: it doesn't make the data written on the executor's thread visible here
+  bool isAsyncReady();
+
+  // Double buffering: prepare the next QR Code while the current one stays available for drawing
+  //   qrcode.prepareNext(nextText); // draw() still shows the current QR Code
+  //   qrcode.swap();                // now draw() shows the next one, and the old one becomes the next
+  // With static buffers (see QRCodeGenerator::setBuffers), give a second qrcode buffer of the same size
+  // Otherwise prepareNext fails while the static buffer holds the current QR Code
+  QRCodeGFX& setNextBuffer(uint8_t *buffer);
+  bool prepareNext(const String &text);
+  bool prepareNext(const char *text);
+  bool prepareNext(const __FlashStringHelper *text);
+  bool prepareNext(const uint8_t *data, size_t length);
+  bool hasNext();
+  void swap();
+  void releaseNext();
+
   // Side length is determined by the QR Code version and the scale property
   // This method is usefull if you need to automatically center the drawing on screen
   // Call it after generating the data
@@ -69,4 +164,55 @@ public:
   // Draw the QRCode on the screen after generating the data
   // You can set releaseData to false if you want to draw the same QRCode multiple times
   bool draw(int16_t x, int16_t y, bool releaseData = true);
+
+  // Incremental drawing: renders the QRCode a few module rows at a time, so slow displays don't block loop()
+  // Rows are counted on screen, so this works with any rotation and scale
+  //   qrcode.beginDraw(x, y);
+  //   while (!qrcode.drawStep(2000)) { /* other work */ } // draw for about 2 ms at a time
+  // drawRows draws a fixed number of rows instead; both return true once the drawing is complete
+  // Generating new data (or releasing it) cancels the drawing
+  bool beginDraw(int16_t x, int16_t y, bool releaseData = true);
+  bool drawStep(uint32_t budgetMicros);
+  bool drawRows(uint8_t count);
+  bool isDrawComplete();
+
+  // Draws straight into a monochrome framebuffer, with the same scale, rotation and quiet zone as draw()
+  // Much faster than going through drawPixel on 1 bit displays: each byte of the buffer is written once
+  // Pixels are set for non-zero colors, so the default colors give dark modules on a set background
+  // Call the display's update method (e.g. display() on an SSD1306) afterwards
+  bool drawTo(QRCodeFramebuffer &framebuffer, int16_t x, int16_t y, bool releaseData = true);
+  bool drawTo(const QRCodeStaticData &data, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y);
+
+  // Turns the generated data into a display list (see QRCodeDisplayList), to redraw it cheaply afterwards
+  // The data is released on success, unless releaseData is false
+  bool buildDisplayList(QRCodeDisplayList &list, bool releaseData = true);
+
+  // Replays a display list with this object's scale, rotation and colors
+  bool draw(const QRCodeDisplayList &list, int16_t x, int16_t y);
+
+  // Stores the generated data in compressed form (see QRCodeCompressed), to keep many QR Codes in memory
+  // The data is released on success, unless releaseData is false
+  bool compressData(QRCodeCompressed &compressed, bool releaseData = true);
+
+  // Draws a compressed QR Code, rebuilding one row at a time (no full QR Code data is needed)
+  // Runs of same-color modules are drawn as one rectangle, like drawDirect
+  bool draw(const QRCodeCompressed &compressed, int16_t x, int16_t y);
+  bool drawTo(const QRCodeCompressed &compressed, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y);
+  int16_t getSideLength(const QRCodeCompressed &compressed);
+
+  // Draws a QR Code read from a file or any other Stream (see QRCodeFile), one row at a time as it is read
+  // Reads one record from the stream's current position. Returns false if it is damaged or cut short,
+  // which is only known at the end: call QRCodeFile::verify first to avoid drawing a damaged one
+  bool drawFrom(Stream &stream, int16_t x, int16_t y);
+  bool drawFrom(Stream &stream, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y);
+
+  // Fused generation and drawing: each row is drawn as soon as the encoder finishes it (see QRCodeGenerator::generateRows)
+  // This skips reading the finished QR Code back, and no data is kept afterwards (there is nothing to release)
+  // Runs of same-color modules are drawn as one rectangle, so there are also fewer display calls than with draw()
+  // With a framebuffer, the fastest rotations are R0 and R180 for Rows, R90 and R270 for Pages
+  // With QRCODE_STATS, drawMicros and drawStackBytes cover the whole call, generation included
+  bool drawDirect(const String &text, int16_t x, int16_t y);
+  bool drawDirect(const char *text, int16_t x, int16_t y);
+  bool drawDirect(const String &text, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y);
+  bool drawDirect(const char *text, QRCodeFramebuffer &framebuffer, int16_t x, int16_t y);
 };
\ No newline at end of file
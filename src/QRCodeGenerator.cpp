@@ -8,19 +8,22 @@ https://github.com/wallysalami/QRCodeGFX
 
 #include "QRCodeGenerator.h"
 
-#ifndef QRCODE_GENERATOR_USE_LESS_MEMORY
-#include "QRCodeLimits.h"
-#endif
+// Destructor
+
+QRCodeGenerator::~QRCodeGenerator() {
+  cancelPayload();
+  cancelGenerate();
+}
 
 // Getters and setters
 
 QRCodeGenerator& QRCodeGenerator::setErrorCorrectionLevel(QRCodeECCLevel level) {
-  errorCorrectionLevel = level;
+  config = config.withErrorCorrectionLevel(level);
   return *this;
 }
 
 QRCodeECCLevel QRCodeGenerator::getErrorCorrectionLevel() {
-  return errorCorrectionLevel;
+  return config.getErrorCorrectionLevel();
 }
 
 QRCodeGenerator& QRCodeGenerator::setBuffers(uint8_t *qrcodeBuffer, uint8_t* tempBuffer, uint16_t size) {
@@ -47,31 +50,61 @@ QRCodeGenerator& QRCodeGenerator::setVersion(uint8_t version) {
 }
 
 QRCodeGenerator& QRCodeGenerator::setVersionRange(uint8_t minVersion, uint8_t maxVersion) {
-  if (minVersion > maxVersion) {
-    uint8_t temp = minVersion;
-    minVersion = maxVersion;
-    maxVersion = temp;
-  }
-
-  if (minVersion < 0) {
-    minVersion = 1;
-  }
-  if (maxVersion > 40) {
-    maxVersion = 40;
-  }
-  this->minVersion = minVersion;
-  this->maxVersion = maxVersion;
+  config = config.withVersionRange(minVersion, maxVersion);
   return *this;
 }
 
 uint8_t QRCodeGenerator::getMinVersion() {
-  return minVersion;
+  return config.getMinVersion();
 }
 
 uint8_t QRCodeGenerator::getMaxVersion() {
-  return maxVersion;
+  return config.getMaxVersion();
+}
+
+QRCodeGenerator& QRCodeGenerator::setMask(QRCodeMask mask) {
+  config = config.withMask(mask);
+  return *this;
+}
+
+QRCodeMask QRCodeGenerator::getMask() {
+  return config.getMask();
+}
+
+QRCodeGenerator& QRCodeGenerator::setConfig(const QRCodeConfig &config) {
+  this->config = config;
+  return *this;
+}
+
+const QRCodeConfig& QRCodeGenerator::getConfig() {
+  return config;
+}
+
+QRCodeGenerator& QRCodeGenerator::setCache(QRCodeCache *cache) {
+  this->cache = cache;
+  return *this;
+}
+
+QRCodeCache* QRCodeGenerator::getCache() {
+  return cache;
+}
+
+QRCodeGenerator& QRCodeGenerator::setMaskExecutor(QRCodeExecutor *executor, uint8_t minVersion) {
+  maskExecutor = executor;
+  parallelMaskMinVersion = minVersion;
+  return *this;
 }
 
+QRCodeExecutor* QRCodeGenerator::getMaskExecutor() {
+  return maskExecutor;
+}
+
+#ifdef QRCODE_STATS
+const QRCodeStats& QRCodeGenerator::getLastStats() {
+  return lastStats;
+}
+#endif
+
 #ifndef QRCODE_GENERATOR_USE_LESS_MEMORY
 
 // Automatic version detection and buffer size calculation methods
@@ -82,40 +115,9 @@ uint8_t QRCodeGenerator::getMinVersion(const String &text) {
 }
 
 uint8_t QRCodeGenerator::getMinVersion(const char* text) {
-  int length = strlen(text);
-  int charsPerVersion;
-
-  int errorMode = (int)errorCorrectionLevel;
-
-  uint16_t capacity = QR_BYTE_BASE[errorMode];
-  bool add100 = false;
-  const uint8_t (*diff)[4] = QR_BYTE_DIFF;
-  if (qrcodegen_isNumeric(text)) {
-    capacity = QR_NUMERIC_BASE[errorMode];
-    diff = QR_NUMERIC_DIFF;
-    add100 = true;
-  } else if (qrcodegen_isAlphanumeric(text)) {
-    capacity = QR_ALPHANUMERIC_BASE[errorMode];
-    diff = QR_ALPHANUMERIC_DIFF;
-  }
-  
-  if (length <= capacity) {
-    return 1;
-  }
-  
-  // Find the minimum version needed
-  for (int version = 2; version <= 40; version++) {
-    capacity += diff[version-2][errorMode];
-    // as mentioned in the qrcodegen.h file, I had to subtract 100 from some values to keep them as 8-bit integers
-    if (add100 && version > 30 && errorMode < 2) {
-      capacity += 100;
-    }
-    if (length <= capacity) {
-      return version;
-    }
-  }
-
-  return 0; // Invalid version
+  struct qrcodegen_TextInfo info = qrcodegen_analyzeText(text);
+  return qrcodegen_getMinVersion(info.mode, info.length, (enum qrcodegen_Ecc)config.getErrorCorrectionLevel(),
+                                 qrcodegen_VERSION_MIN, qrcodegen_VERSION_MAX, NULL);
 }
 
 uint16_t QRCodeGenerator::getBufferSize(const String &text) {
@@ -123,7 +125,6 @@ uint16_t QRCodeGenerator::getBufferSize(const String &text) {
 }
 
 uint16_t QRCodeGenerator::getBufferSize(const char* text) {
-  int length = strlen(text);
   int version = getMinVersion(text);
   if (version == 0) {
     return 0;
@@ -131,6 +132,33 @@ uint16_t QRCodeGenerator::getBufferSize(const char* text) {
   return qrcodegen_BUFFER_LEN_FOR_VERSION(version);
 }
 
+uint8_t QRCodeGenerator::getMinVersion(const __FlashStringHelper *text) {
+  struct qrcodegen_TextInfo info = analyzeFlashText(text);
+  return qrcodegen_getMinVersion(info.mode, info.length, (enum qrcodegen_Ecc)config.getErrorCorrectionLevel(),
+                                 qrcodegen_VERSION_MIN, qrcodegen_VERSION_MAX, NULL);
+}
+
+uint16_t QRCodeGenerator::getBufferSize(const __FlashStringHelper *text) {
+  int version = getMinVersion(text);
+  if (version == 0) {
+    return 0;
+  }
+  return qrcodegen_BUFFER_LEN_FOR_VERSION(version);
+}
+
+uint8_t QRCodeGenerator::getMinVersion(const uint8_t *data, size_t length) {
+  return qrcodegen_getMinVersion(qrcodegen_Mode_BYTE, length, (enum qrcodegen_Ecc)config.getErrorCorrectionLevel(),
+                                 qrcodegen_VERSION_MIN, qrcodegen_VERSION_MAX, NULL);
+}
+
+uint16_t QRCodeGenerator::getBufferSize(const uint8_t *data, size_t length) {
+  int version = getMinVersion(data, length);
+  if (version == 0) {
+    return 0;
+  }
+  return qrcodegen_BUFFER_LEN_FOR_VERSION(version);
+}
+
 #endif
 
 // Generation methods
@@ -140,69 +168,686 @@ uint8_t* QRCodeGenerator::generateData(const String &text) {
 }
 
 uint8_t* QRCodeGenerator::generateData(const char* text) {
-  uint8_t minVersion = getMinVersion();
-  uint8_t maxVersion = getMaxVersion();
+  QRCODE_STATS_SCOPE(lastStats);
 
-#ifndef QRCODE_GENERATOR_USE_LESS_MEMORY
-  uint8_t minVersionForText = getMinVersion(text);
-  if (minVersionForText > maxVersion) {
+  // Scan the text only once, both version detection and encoding reuse the result
+  struct qrcodegen_TextInfo info = qrcodegen_analyzeText(text);
+
+  uint8_t minVersion, maxVersion;
+  if (!config.getVersionRange(info.mode, info.length, minVersion, maxVersion, QRCODE_ENCODE_STATS(lastStats))) {
+    return NULL; // error: text too long for the version range
+  }
+
+  QRCodeCacheKey cacheKey;
+  const uint8_t *cachedQRCode = findInCache(cacheKey, (const uint8_t *)text, info.length, false, false, maxVersion);
+  if (cachedQRCode != NULL) {
+    return loadFromCache(cachedQRCode);
+  }
+
+  uint8_t *qrcodeBuffer, *tempBuffer;
+  if (!acquireBuffers(maxVersion, qrcodeBuffer, tempBuffer)) {
     return NULL;
   }
+  uint8_t *cacheSlot = addToCache(cacheKey, (const uint8_t *)text, false, maxVersion);
+
+  bool success = encodeText(text, info, minVersion, maxVersion, tempBuffer, qrcodeBuffer);
 
-  uint8_t version = minVersionForText;
-  if (minVersionForText < minVersion) {
-    version = minVersion;
+  storeInCache(cacheSlot, success, qrcodeBuffer);
+  return releaseBuffers(success, qrcodeBuffer, tempBuffer, maxVersion);
+}
+
+uint8_t* QRCodeGenerator::generateData(const __FlashStringHelper *text) {
+  QRCODE_STATS_SCOPE(lastStats);
+
+  struct qrcodegen_TextInfo info = analyzeFlashText(text);
+
+  uint8_t minVersion, maxVersion;
+  if (!config.getVersionRange(info.mode, info.length, minVersion, maxVersion, QRCODE_ENCODE_STATS(lastStats))
+      || qrcodegen_calcSegmentBufferSize(info.mode, info.length) > (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion)) {
+    return NULL; // error: text too long for the version range
   }
 
-  minVersion = version;
-  maxVersion = version;
-#else
-  uint8_t version = maxVersion;
-#endif
+  QRCodeCacheKey cacheKey;
+  const uint8_t *cachedQRCode = findInCache(cacheKey, (const uint8_t *)text, info.length, false, true, maxVersion);
+  if (cachedQRCode != NULL) {
+    return loadFromCache(cachedQRCode);
+  }
 
-  uint8_t *qrcodeBuffer = this->qrcodeBuffer;
-  uint8_t *tempBuffer = this->tempBuffer;
-  uint16_t bufferSizeForVersion = qrcodegen_BUFFER_LEN_FOR_VERSION(version);
+  uint8_t *qrcodeBuffer, *tempBuffer;
+  if (!acquireBuffers(maxVersion, qrcodeBuffer, tempBuffer)) {
+    return NULL;
+  }
+  uint8_t *cacheSlot = addToCache(cacheKey, (const uint8_t *)text, true, maxVersion);
+
+  // The text is packed into the segment straight from flash, a chunk at a time
+  // It never needs to be copied to RAM as a whole
+  struct qrcodegen_Segment segment = qrcodegen_beginSegment(info.mode, tempBuffer);
+  const char *flashText = (const char *)text;
+  char chunk[FLASH_CHUNK_LENGTH];
+  size_t length;
+  while ((length = readFlashChunk(flashText, chunk)) > 0) {
+    qrcodegen_appendToSegment(&segment, chunk, length);
+  }
+
+  bool success = encodeSegments(&segment, info.length > 0 ? 1 : 0, minVersion, maxVersion, tempBuffer, qrcodeBuffer);
+
+  storeInCache(cacheSlot, success, qrcodeBuffer);
+  return releaseBuffers(success, qrcodeBuffer, tempBuffer, maxVersion);
+}
+
+uint8_t* QRCodeGenerator::generateData(const uint8_t *data, size_t length) {
+  QRCODE_STATS_SCOPE(lastStats);
+
+  if (qrcodegen_calcSegmentBufferSize(qrcodegen_Mode_BYTE, length) == SIZE_MAX) {
+    return NULL; // error: data too long for any QR Code
+  }
+
+  uint8_t minVersion, maxVersion;
+  if (!config.getVersionRange(qrcodegen_Mode_BYTE, length, minVersion, maxVersion, QRCODE_ENCODE_STATS(lastStats))) {
+    return NULL; // error: data too long for the version range
+  }
+
+  QRCodeCacheKey cacheKey;
+  const uint8_t *cachedQRCode = findInCache(cacheKey, data, length, true, false, maxVersion);
+  if (cachedQRCode != NULL) {
+    return loadFromCache(cachedQRCode);
+  }
+
+  uint8_t *qrcodeBuffer, *tempBuffer;
+  if (!acquireBuffers(maxVersion, qrcodeBuffer, tempBuffer)) {
+    return NULL;
+  }
+  uint8_t *cacheSlot = addToCache(cacheKey, data, false, maxVersion);
+
+  // The segment points straight to the caller's data, the encoder only reads from it
+  struct qrcodegen_Segment segment;
+  segment.mode = qrcodegen_Mode_BYTE;
+  segment.numChars = (int)length;
+  segment.bitLength = (int)length * 8;
+  segment.data = (uint8_t *)data;
+
+  bool success = encodeSegments(&segment, 1, minVersion, maxVersion, tempBuffer, qrcodeBuffer);
 
-  if (qrcodeBuffer == NULL) { // no buffer provided
-    qrcodeBuffer = (uint8_t *)malloc(bufferSizeForVersion);
-    if (qrcodeBuffer == NULL) {
-      return NULL; // error: not enough memory
+  storeInCache(cacheSlot, success, qrcodeBuffer);
+  return releaseBuffers(success, qrcodeBuffer, tempBuffer, maxVersion);
+}
+
+// Incremental generation methods
+
+QRCodePayloadWriter& QRCodeGenerator::beginPayload(size_t maxLength) {
+  cancelPayload();
+
+  // Reserve room for the worst case, a payload of maxLength bytes in byte mode
+  // Both buffers are free until encoding starts, so the payload is collected in the temp buffer and
+  // spills into the qrcode buffer: numeric and alphanumeric payloads can be longer than one buffer
+  payloadVersion = qrcodegen_getMinVersion(qrcodegen_Mode_BYTE, maxLength, (enum qrcodegen_Ecc)config.getErrorCorrectionLevel(),
+                                           getMinVersion(), getMaxVersion(), NULL);
+  if (payloadVersion == 0) {
+    payloadVersion = getMaxVersion(); // it may still fit in numeric or alphanumeric mode
+  }
+  if (this->qrcodeBuffer != NULL) {
+    // Provided buffers may be smaller, keep the largest version they can hold
+    while (payloadVersion > getMinVersion() && qrcodegen_BUFFER_LEN_FOR_VERSION(payloadVersion) > bufferSize) {
+      payloadVersion--;
     }
   }
-  else if (bufferSizeForVersion > bufferSize) {
-    return NULL;  // error: provided buffer too small for required version
+
+  uint8_t *tempBuffer, *qrcodeBuffer;
+  if (!acquireBuffers(payloadVersion, qrcodeBuffer, tempBuffer)) {
+    payloadWriter.begin(NULL, 0);
+    return payloadWriter; // error: not enough memory, endPayload will return NULL
+  }
+  size_t capacity = qrcodegen_BUFFER_LEN_FOR_VERSION(payloadVersion);
+  if (maxLength < capacity) {
+    capacity = maxLength;
   }
+  size_t spillCapacity = qrcodegen_BUFFER_LEN_FOR_VERSION(payloadVersion);
+  if (maxLength - capacity < spillCapacity) {
+    spillCapacity = maxLength - capacity;
+  }
+  payloadWriter.begin(tempBuffer, capacity, qrcodeBuffer, spillCapacity);
 
-  if (tempBuffer == NULL) { // no buffer provided
-    tempBuffer = (uint8_t *)malloc(bufferSizeForVersion);
-    if (tempBuffer == NULL) {
-      if (this->qrcodeBuffer == NULL) {
-        free(qrcodeBuffer);
-      }
-      return NULL; // error: not enough memory
+  return payloadWriter;
+}
+
+uint8_t* QRCodeGenerator::endPayload() {
+  QRCODE_STATS_SCOPE(lastStats);
+
+  uint8_t *tempBuffer = payloadWriter.getBuffer();
+  uint8_t *qrcodeBuffer = payloadWriter.getSpillBuffer();
+  if (tempBuffer == NULL) {
+    return NULL; // error: beginPayload not called or not enough memory
+  }
+  struct qrcodegen_TextInfo info = payloadWriter.getTextInfo();
+  bool overflow = payloadWriter.hasOverflowed();
+  // The cache needs the payload in one piece, so payloads that spilled into the qrcode buffer skip it
+  bool spilled = info.length > (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION(payloadVersion);
+
+  uint8_t minVersion, maxVersion;
+  if (overflow || !config.getVersionRange(info.mode, info.length, minVersion, maxVersion, QRCODE_ENCODE_STATS(lastStats))) {
+    cancelPayload();
+    return NULL; // error: payload too long
+  }
+  if (maxVersion > payloadVersion) {
+    maxVersion = payloadVersion; // the buffers were sized for this version
+  }
+
+  QRCodeCacheKey cacheKey;
+  const uint8_t *cachedQRCode = spilled ? NULL : findInCache(cacheKey, tempBuffer, info.length, false, false, maxVersion);
+  if (cachedQRCode != NULL) {
+    memcpy(qrcodeBuffer, cachedQRCode, qrcodegen_BUFFER_LEN_FOR_VERSION((cachedQRCode[0] - 17) / 4));
+    releaseBuffer(this->tempBuffer, tempBuffer, payloadVersion);
+    payloadWriter.begin(NULL, 0);
+    return qrcodeBuffer;
+  }
+
+  if (minVersion > maxVersion
+      || qrcodegen_calcSegmentBufferSize(info.mode, info.length) > (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion)) {
+    cancelPayload();
+    return NULL; // error: payload too long for the buffers
+  }
+  // Added before encoding, because the payload is overwritten by the segment
+  uint8_t *cacheSlot = spilled ? NULL : addToCache(cacheKey, tempBuffer, false, maxVersion);
+
+  // The payload is packed into the segment in place, a chunk at a time
+  // A packed chunk never takes more bytes than its characters did, so it doesn't reach text that wasn't read yet
+  struct qrcodegen_Segment segment = qrcodegen_beginSegment(info.mode, tempBuffer);
+  char chunk[FLASH_CHUNK_LENGTH];
+  size_t offset = 0, length;
+  while ((length = payloadWriter.copyText(offset, chunk, FLASH_CHUNK_LENGTH)) > 0) {
+    qrcodegen_appendToSegment(&segment, chunk, length);
+    offset += length;
+  }
+  payloadWriter.begin(NULL, 0);
+
+  bool success = encodeSegments(&segment, info.length > 0 ? 1 : 0, minVersion, maxVersion, tempBuffer, qrcodeBuffer);
+
+  storeInCache(cacheSlot, success, qrcodeBuffer);
+  return releaseBuffers(success, qrcodeBuffer, tempBuffer, payloadVersion);
+}
+
+void QRCodeGenerator::cancelPayload() {
+  uint8_t *tempBuffer = payloadWriter.getBuffer();
+  if (tempBuffer != NULL) {
+    releaseBuffers(false, payloadWriter.getSpillBuffer(), tempBuffer, payloadVersion);
+  }
+  payloadWriter.begin(NULL, 0);
+}
+
+uint8_t* QRCodeGenerator::generateFrom(Stream &stream, char terminator, size_t maxLength) {
+  QRCodePayloadWriter &writer = beginPayload(maxLength);
+  writer.readFrom(stream, terminator);
+  return endPayload();
+}
+
+// Batch generation methods
+
+struct QRCodeBatch {
+  QRCodeGenerator *generator;
+  QRCodeBatchItem *items;
+  uint8_t *scratch;
+  uint16_t scratchLength;
+};
+
+bool QRCodeGenerator::generateBatch(QRCodeBatchItem *items, size_t count, QRCodeExecutor *executor) {
+  QRCodeSerialExecutor serialExecutor;
+  if (executor == NULL) {
+    executor = &serialExecutor;
+  }
+
+  uint8_t workerCount = executor->getWorkerCount();
+  uint16_t scratchLength = qrcodegen_BUFFER_LEN_FOR_VERSION(getMaxVersion());
+  uint8_t *scratch = this->tempBuffer;
+  if (workerCount > 1 || scratch == NULL || bufferSize < scratchLength) {
+    scratch = (uint8_t *)allocate((size_t)workerCount * scratchLength);
+    if (scratch == NULL) {
+      return false; // error: not enough memory for the scratch buffers
     }
   }
-  else if (bufferSizeForVersion > bufferSize) {
-    if (this->qrcodeBuffer == NULL) {
-      free(qrcodeBuffer);
+
+  QRCodeBatch batch = {this, items, scratch, scratchLength};
+  executor->parallelFor(count, generateBatchTask, &batch);
+
+  if (scratch != this->tempBuffer) {
+    deallocate(scratch, (size_t)workerCount * scratchLength);
+  }
+
+  for (size_t i = 0; i < count; i++) {
+    if (!items[i].success) {
+      return false;
     }
-    return NULL;  // error: provided buffer too small for required version
   }
+  return true;
+}
 
-  bool success = qrcodegen_encodeText(text, tempBuffer, qrcodeBuffer, (enum qrcodegen_Ecc)errorCorrectionLevel,
-                                      minVersion, maxVersion, qrcodegen_Mask_AUTO, false);
+void QRCodeGenerator::generateBatchTask(size_t index, uint8_t worker, void *context) {
+  QRCodeBatch *batch = (QRCodeBatch *)context;
+  uint8_t *tempBuffer = batch->scratch + (size_t)worker * batch->scratchLength;
+  batch->items[index].success = batch->generator->generateBatchItem(batch->items[index], tempBuffer);
+}
 
-  if (this->tempBuffer == NULL) {
-    free(tempBuffer);
+bool QRCodeGenerator::generateBatchItem(QRCodeBatchItem &item, uint8_t *tempBuffer) {
+  struct qrcodegen_TextInfo info = qrcodegen_analyzeText(item.text);
+  uint8_t minVersion, maxVersion;
+  if (!config.getVersionRange(info.mode, info.length, minVersion, maxVersion)) {
+    return false; // error: text too long for the version range
   }
 
-  if (!success) {
-    if (this->qrcodeBuffer == NULL) {
-      free(qrcodeBuffer);
+  while (maxVersion >= minVersion && qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion) > item.size) {
+    maxVersion--;
+  }
+  if (maxVersion < minVersion) {
+    return false; // error: output slot too small
+  }
+
+  return config.encodeText(item.text, info, minVersion, maxVersion, tempBuffer, item.qrcode);
+}
+
+// Time-sliced generation methods
+
+struct QRCodeEncodeJob {
+  struct qrcodegen_Encoder encoder;
+  struct qrcodegen_Segment segment;
+  uint8_t *qrcodeBuffer;
+  uint8_t *tempBuffer;
+  uint8_t *cacheSlot;
+  uint8_t version;  // of the buffers
+  bool finished;
+};
+
+bool QRCodeGenerator::beginGenerate(const String &text) {
+  return beginGenerate(text.c_str());
+}
+
+bool QRCodeGenerator::beginGenerate(const char* text) {
+  cancelGenerate();
+  // The steps add their phases to the stats until endGenerate
+  QRCODE_STATS_DO(QRCodeStatsScope::reset(lastStats));
+
+  struct qrcodegen_TextInfo info = qrcodegen_analyzeText(text);
+
+  uint8_t minVersion, maxVersion;
+  if (!config.getVersionRange(info.mode, info.length, minVersion, maxVersion, QRCODE_ENCODE_STATS(lastStats))
+      || qrcodegen_calcSegmentBufferSize(info.mode, info.length) > (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion)) {
+    return false; // error: text too long for the version range
+  }
+
+  QRCodeEncodeJob *job = (QRCodeEncodeJob *)allocate(sizeof(QRCodeEncodeJob));
+  if (job == NULL) {
+    return false;
+  }
+  job->tempBuffer = NULL;
+  job->cacheSlot = NULL;
+  job->version = maxVersion;
+
+  QRCodeCacheKey cacheKey;
+  const uint8_t *cachedQRCode = findInCache(cacheKey, (const uint8_t *)text, info.length, false, false, maxVersion);
+  if (cachedQRCode != NULL) {
+    // Nothing left to do, endGenerate just returns the copy
+    job->qrcodeBuffer = loadFromCache(cachedQRCode);
+    job->finished = true;
+    if (job->qrcodeBuffer == NULL) {
+      deallocate(job, sizeof(QRCodeEncodeJob));
+      return false;
     }
+    encodeJob = job;
+    return true;
+  }
+
+  if (!acquireBuffers(maxVersion, job->qrcodeBuffer, job->tempBuffer)) {
+    deallocate(job, sizeof(QRCodeEncodeJob));
+    return false;
+  }
+  job->cacheSlot = addToCache(cacheKey, (const uint8_t *)text, false, maxVersion);
+
+  // The text is packed into the segment right away, so the caller can let it go
+  // The encoder reads the segment before it starts using the temp buffer for anything else
+  job->segment = qrcodegen_beginSegment(info.mode, job->tempBuffer);
+  qrcodegen_appendToSegment(&job->segment, text, info.length);
+
+  if (!qrcodegen_beginEncode(&job->encoder, &job->segment, info.length > 0 ? 1 : 0, (enum qrcodegen_Ecc)config.getErrorCorrectionLevel(),
+                             minVersion, maxVersion, (enum qrcodegen_Mask)config.getMask(), false, job->tempBuffer, job->qrcodeBuffer,
+                             QRCODE_ENCODE_STATS(lastStats))) {
+    storeInCache(job->cacheSlot, false, job->qrcodeBuffer);
+    releaseBuffers(false, job->qrcodeBuffer, job->tempBuffer, job->version);
+    deallocate(job, sizeof(QRCodeEncodeJob));
+    return false;
+  }
+  job->finished = false;
+
+  encodeJob = job;
+  return true;
+}
+
+uint8_t QRCodeGenerator::step(uint32_t budgetMicros) {
+  if (encodeJob == NULL) {
+    return 100;
+  }
+
+  if (!encodeJob->finished) {
+    uint32_t start = micros();
+    do {
+      encodeJob->finished = qrcodegen_encodeStep(&encodeJob->encoder) == qrcodegen_EncodePhase_DONE;
+    } while (!encodeJob->finished && micros() - start < budgetMicros);
+  }
+
+  return encodeJob->finished ? 100 : qrcodegen_getEncodeProgress(&encodeJob->encoder);
+}
+
+bool QRCodeGenerator::isGenerating() {
+  return encodeJob != NULL;
+}
+
+uint8_t* QRCodeGenerator::endGenerate() {
+  if (encodeJob == NULL) {
     return NULL;
   }
 
+  while (!encodeJob->finished) {
+    encodeJob->finished = qrcodegen_encodeStep(&encodeJob->encoder) == qrcodegen_EncodePhase_DONE;
+  }
+
+  uint8_t *qrcodeBuffer = encodeJob->qrcodeBuffer;
+  storeInCache(encodeJob->cacheSlot, true, qrcodeBuffer);
+  releaseBuffer(this->tempBuffer, encodeJob->tempBuffer, encodeJob->version);
+  deallocate(encodeJob, sizeof(QRCodeEncodeJob));
+  encodeJob = NULL;
+
   return qrcodeBuffer;
+}
+
+void QRCodeGenerator::cancelGenerate() {
+  if (encodeJob == NULL) {
+    return;
+  }
+
+  // The cache slot was reserved for a symbol that will never be stored
+  storeInCache(encodeJob->cacheSlot, false, encodeJob->qrcodeBuffer);
+  releaseBuffers(false, encodeJob->qrcodeBuffer, encodeJob->tempBuffer, encodeJob->version);
+  deallocate(encodeJob, sizeof(QRCodeEncodeJob));
+  encodeJob = NULL;
+}
+
+// Asynchronous generation methods
+
+struct QRCodeAsyncJob {
+  QRCodeGenerator *generator;
+  QRCodeCallback callback;
+  void *context;
+  char text[1]; // allocated with room for the whole text
+};
+
+bool QRCodeGenerator::generateAsync(const String &text, QRCodeExecutor &executor, QRCodeCallback callback, void *context) {
+  return generateAsync(text.c_str(), executor, callback, context);
+}
+
+bool QRCodeGenerator::generateAsync(const char* text, QRCodeExecutor &executor, QRCodeCallback callback, void *context) {
+  size_t length = strlen(text);
+  // Allocated before the executor starts, while the generator is still the caller's
+  QRCodeAsyncJob *job = (QRCodeAsyncJob *)allocate(sizeof(QRCodeAsyncJob) + length);
+  if (job == NULL) {
+    return false;
+  }
+  job->generator = this;
+  job->callback = callback;
+  job->context = context;
+  memcpy(job->text, text, length + 1);
+
+  executor.submit(generateAsyncTask, job);
+  return true;
+}
+
+void QRCodeGenerator::generateAsyncTask(size_t index, uint8_t worker, void *context) {
+  QRCodeAsyncJob *job = (QRCodeAsyncJob *)context;
+  QRCodeGenerator *generator = job->generator;
+  uint8_t *qrcode = generator->generateData(job->text);
+  QRCodeCallback callback = job->callback;
+  void *callbackContext = job->context;
+
+  // The job was allocated before generateData reset the stats, so it is not part of the heap they report
+  QRCODE_STATS_DO(uint32_t heapBytes = generator->lastStats.heapBytes);
+  generator->deallocate(job, sizeof(QRCodeAsyncJob) + strlen(job->text));
+  QRCODE_STATS_DO(generator->lastStats.heapBytes = heapBytes);
+
+  callback(qrcode, callbackContext);
+}
+
+// Private helpers shared by the generation methods
+
+bool QRCodeGenerator::encodeText(const char *text, const struct qrcodegen_TextInfo &info, uint8_t minVersion, uint8_t maxVersion,
+                                 uint8_t *tempBuffer, uint8_t *qrcodeBuffer) {
+  size_t maskBuffersSize;
+  uint8_t *maskBuffers = acquireMaskBuffers(maxVersion, maskBuffersSize);
+  bool success = config.encodeText(text, info, minVersion, maxVersion, tempBuffer, qrcodeBuffer,
+                                   maskBuffers != NULL ? maskExecutor : NULL, maskBuffers, QRCODE_ENCODE_STATS(lastStats));
+  deallocate(maskBuffers, maskBuffersSize);
+  return success;
+}
+
+bool QRCodeGenerator::encodeSegments(const struct qrcodegen_Segment *segments, size_t count, uint8_t minVersion, uint8_t maxVersion,
+                                     uint8_t *tempBuffer, uint8_t *qrcodeBuffer) {
+  size_t maskBuffersSize;
+  uint8_t *maskBuffers = acquireMaskBuffers(maxVersion, maskBuffersSize);
+  bool success = config.encodeSegments(segments, count, minVersion, maxVersion, tempBuffer, qrcodeBuffer,
+                                       maskBuffers != NULL ? maskExecutor : NULL, maskBuffers, QRCODE_ENCODE_STATS(lastStats));
+  deallocate(maskBuffers, maskBuffersSize);
+  return success;
+}
+
+uint8_t* QRCodeGenerator::acquireMaskBuffers(uint8_t maxVersion, size_t &size) {
+  size = 0;
+  if (maskExecutor == NULL || config.getMask() != QRCodeMask::Auto || maxVersion < parallelMaskMinVersion) {
+    return NULL;
+  }
+
+  // One grid copy per worker, the masks are applied to them concurrently
+  size = (size_t)maskExecutor->getWorkerCount() * qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion);
+  uint8_t *maskBuffers = (uint8_t *)allocate(size);
+  if (maskBuffers == NULL) {
+    size = 0; // the masks are scored serially instead
+  }
+  return maskBuffers;
+}
+
+struct qrcodegen_TextInfo QRCodeGenerator::analyzeFlashText(const __FlashStringHelper *text) {
+  struct qrcodegen_TextInfo info = {0, qrcodegen_Mode_NUMERIC};
+  const char *flashText = (const char *)text;
+  char chunk[FLASH_CHUNK_LENGTH];
+  size_t length;
+  while ((length = readFlashChunk(flashText, chunk)) > 0) {
+    qrcodegen_extendTextInfo(&info, chunk, length);
+  }
+  return info;
+}
+
+size_t QRCodeGenerator::readFlashChunk(const char *&flashText, char *chunk) {
+  // Flash can't be read through normal pointers on every board (e.g. AVR)
+  // So flash strings are processed in small chunks copied to the stack
+  size_t length = 0;
+  while (length < FLASH_CHUNK_LENGTH) {
+    char c = pgm_read_byte(flashText);
+    if (c == '\0') {
+      break;
+    }
+    chunk[length++] = c;
+    flashText++;
+  }
+  return length;
+}
+
+const uint8_t* QRCodeGenerator::findInCache(QRCodeCacheKey &key, const uint8_t *payload, size_t length,
+                                            bool binary, bool payloadInFlash, uint8_t maxVersion) {
+  return config.findInCache(cache, key, payload, length, binary, payloadInFlash, maxVersion);
+}
+
+uint8_t* QRCodeGenerator::loadFromCache(const uint8_t *cachedQRCode) {
+  uint8_t version = (cachedQRCode[0] - 17) / 4;
+  uint8_t *qrcodeBuffer = acquireBuffer(this->qrcodeBuffer, version);
+  if (qrcodeBuffer != NULL) {
+    memcpy(qrcodeBuffer, cachedQRCode, qrcodegen_BUFFER_LEN_FOR_VERSION(version));
+  }
+  return qrcodeBuffer;
+}
+
+uint8_t* QRCodeGenerator::addToCache(const QRCodeCacheKey &key, const uint8_t *payload, bool payloadInFlash, uint8_t version) {
+  if (cache == NULL) {
+    return NULL;
+  }
+  return cache->add(key, payload, payloadInFlash, qrcodegen_BUFFER_LEN_FOR_VERSION(version));
+}
+
+void QRCodeGenerator::storeInCache(uint8_t *cacheSlot, bool success, const uint8_t *qrcodeBuffer) {
+  if (cacheSlot == NULL) {
+    return;
+  }
+
+  if (success) {
+    memcpy(cacheSlot, qrcodeBuffer, qrcodegen_BUFFER_LEN_FOR_VERSION((qrcodeBuffer[0] - 17) / 4));
+  }
+  else {
+    cache->remove(cacheSlot);
+  }
+}
+
+bool QRCodeGenerator::acquireBuffers(uint8_t version, uint8_t *&qrcodeBuffer, uint8_t *&tempBuffer) {
+  qrcodeBuffer = acquireBuffer(this->qrcodeBuffer, version);
+  if (qrcodeBuffer == NULL) {
+    return false;
+  }
+
+  tempBuffer = acquireBuffer(this->tempBuffer, version);
+  if (tempBuffer == NULL) {
+    releaseBuffer(this->qrcodeBuffer, qrcodeBuffer, version);
+    return false;
+  }
+
+  return true;
+}
+
+uint8_t* QRCodeGenerator::releaseBuffers(bool success, uint8_t *qrcodeBuffer, uint8_t *tempBuffer, uint8_t version) {
+  releaseBuffer(this->tempBuffer, tempBuffer, version);
+
+  if (!success) {
+    releaseBuffer(this->qrcodeBuffer, qrcodeBuffer, version);
+    return NULL;
+  }
+
+  return qrcodeBuffer;
+}
+
+uint8_t* QRCodeGenerator::acquireBuffer(uint8_t *providedBuffer, uint8_t version) {
+  uint16_t bufferSizeForVersion = qrcodegen_BUFFER_LEN_FOR_VERSION(version);
+
+  if (providedBuffer == NULL) { // no buffer provided
+    return (uint8_t *)allocate(bufferSizeForVersion); // NULL if there is not enough memory
+  }
+  else if (bufferSizeForVersion > bufferSize) {
+    return NULL;  // error: provided buffer too small for required version
+  }
+
+  return providedBuffer;
+}
+
+void QRCodeGenerator::releaseBuffer(uint8_t *providedBuffer, uint8_t *buffer, uint8_t version) {
+  if (providedBuffer == NULL) {
+    deallocate(buffer, qrcodegen_BUFFER_LEN_FOR_VERSION(version));
+  }
+}
+
+void* QRCodeGenerator::allocate(size_t size) {
+  void *buffer = malloc(size);
+#ifdef QRCODE_STATS
+  if (buffer != NULL) {
+    lastStats.allocatedBytes += size;
+    lastStats.allocations++;
+    lastStats.heapBytes += size;
+    if (lastStats.heapBytes > lastStats.peakHeapBytes) {
+      lastStats.peakHeapBytes = lastStats.heapBytes;
+    }
+  }
+#endif
+  return buffer;
+}
+
+void QRCodeGenerator::deallocate(void *buffer, size_t size) {
+  free(buffer);
+#ifdef QRCODE_STATS
+  // Buffers allocated before the stats were reset (e.g. by beginPayload) are not counted in heapBytes
+  if (buffer != NULL) {
+    lastStats.heapBytes = size < lastStats.heapBytes ? lastStats.heapBytes - size : 0;
+  }
+#endif
+}
+
+// Row streaming methods
+
+bool QRCodeGenerator::generateRows(const String &text, QRCodeRowSink &sink) {
+  return generateRows(text.c_str(), sink);
+}
+
+bool QRCodeGenerator::generateRows(const char* text, QRCodeRowSink &sink) {
+  QRCODE_STATS_SCOPE(lastStats);
+
+  struct qrcodegen_TextInfo info = qrcodegen_analyzeText(text);
+
+  uint8_t minVersion, maxVersion;
+  if (!config.getVersionRange(info.mode, info.length, minVersion, maxVersion, QRCODE_ENCODE_STATS(lastStats))
+      || qrcodegen_calcSegmentBufferSize(info.mode, info.length) > (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion)) {
+    return false; // error: text too long for the version range
+  }
+
+  QRCodeCacheKey cacheKey;
+  const uint8_t *cachedQRCode = findInCache(cacheKey, (const uint8_t *)text, info.length, false, false, maxVersion);
+  if (cachedQRCode != NULL) {
+    emitRows(cachedQRCode, sink);
+    return true;
+  }
+
+  uint8_t *qrcodeBuffer, *tempBuffer;
+  if (!acquireBuffers(maxVersion, qrcodeBuffer, tempBuffer)) {
+    return false;
+  }
+  uint8_t *cacheSlot = addToCache(cacheKey, (const uint8_t *)text, false, maxVersion);
+
+  struct qrcodegen_Segment segment = qrcodegen_beginSegment(info.mode, tempBuffer);
+  qrcodegen_appendToSegment(&segment, text, info.length);
+
+  struct qrcodegen_Encoder encoder;
+  bool success = qrcodegen_beginEncode(&encoder, &segment, info.length > 0 ? 1 : 0, (enum qrcodegen_Ecc)config.getErrorCorrectionLevel(),
+                                       minVersion, maxVersion, (enum qrcodegen_Mask)config.getMask(), false, tempBuffer, qrcodeBuffer,
+                                       QRCODE_ENCODE_STATS(lastStats));
+  if (success) {
+    // The masked rows are only written back when the cache needs the finished QR Code
+    qrcodegen_setRowSink(&encoder, forwardRow, &sink, cacheSlot != NULL);
+    while (qrcodegen_encodeStep(&encoder) != qrcodegen_EncodePhase_DONE);
+    sink.end();
+  }
+
+  storeInCache(cacheSlot, success, qrcodeBuffer);
+  releaseBuffers(false, qrcodeBuffer, tempBuffer, maxVersion);
+  return success;
+}
+
+void QRCodeGenerator::forwardRow(int y, const uint8_t modules[], int size, void *context) {
+  QRCodeRowSink *sink = (QRCodeRowSink *)context;
+  if (y == 0) {
+    sink->begin(size);
+  }
+  sink->writeRow(y, modules, size);
+}
+
+void QRCodeGenerator::emitRows(const uint8_t *qrcode, QRCodeRowSink &sink) {
+  int size = qrcodegen_getSize(qrcode);
+  uint8_t modules[(qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8];
+  sink.begin(size);
+  for (int y = 0; y < size; y++) {
+    memset(modules, 0, sizeof(modules));
+    for (int x = 0; x < size; x++) {
+      if (qrcodegen_getModule(qrcode, x, y)) {
+        modules[x >> 3] |= 0x80 >> (x & 7);
+      }
+    }
+    sink.writeRow(y, modules, size);
+  }
+  sink.end();
 }
\ No newline at end of file
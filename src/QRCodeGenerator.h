@@ -10,36 +10,87 @@ https://github.com/wallysalami/QRCodeGFX
 
 #include <Arduino.h>
 #include "qrcodegen.h"
+#include "QRCodePayloadWriter.h"
+#include "QRCodeCache.h"
+#include "QRCodeExecutor.h"
+#include "QRCodeConfig.h"
+#include "QRCodeStats.h"
+#include "QRCodeRowSink.h"
+#include "QRCodeSettings.h"
 
-// QRCode minimum version detection uses some big static variables as tables
-// That might be a problem for some devices with low memory (e.g. Arduino Uno)
-// You can save memory by defining QRCODE_GENERATOR_USE_LESS_MEMORY here (uncomment the line below)
-// This will disable the tables and some methods at compile time, reducing memory usage
-// In that case, you must set the version range according to your device capabilities
-// Please check the text size limits for each version at the link below
-// https://github.com/ricmoo/QRCode/tree/master?tab=readme-ov-file#data-capacities
-
-//#define QRCODE_GENERATOR_USE_LESS_MEMORY
-
-enum class QRCodeECCLevel {
-  Low,
-  Medium,
-  Quartile,
-  High
+// One payload of a batch, see QRCodeGenerator::generateBatch()
+struct QRCodeBatchItem {
+  const char *text;   // text to encode
+  uint8_t *qrcode;    // output slot (qrcodegen layout)
+  uint16_t size;      // output slot size, limits the version like static buffers do
+  bool success;       // set by generateBatch
 };
 
+// State of a time-sliced generation, see QRCodeGenerator::beginGenerate()
+struct QRCodeEncodeJob;
+
+// Receives the result of QRCodeGenerator::generateAsync(), NULL if generation failed
+typedef void (*QRCodeCallback)(uint8_t *qrcode, void *context);
+
 class QRCodeGenerator {
 private:
-  QRCodeECCLevel errorCorrectionLevel = QRCodeECCLevel::Low;
-  uint8_t minVersion = 1;
-  uint8_t maxVersion = 40;
+  // Error correction level, version range and mask
+  QRCodeConfig config;
+
+  // Optional cache of generated symbols, see setCache()
+  QRCodeCache *cache = NULL;
+
+  // Optional executor for the mask trials, see setMaskExecutor()
+  QRCodeExecutor *maskExecutor = NULL;
+  uint8_t parallelMaskMinVersion = 25;
 
   // In case you prefer to use static variables instead of dynamic memory allocation
   uint8_t *qrcodeBuffer = NULL; 
   uint8_t *tempBuffer = NULL;
   uint16_t bufferSize = 0;
 
+  // Payload being collected between beginPayload() and endPayload()
+  QRCodePayloadWriter payloadWriter;
+  uint8_t payloadVersion = 0;
+
+  // Generation started by beginGenerate() and not yet finished (allocated only while it runs)
+  QRCodeEncodeJob *encodeJob = NULL;
+
+#ifdef QRCODE_STATS
+  QRCodeStats lastStats = {};
+#endif
+
+  // A multiple of 6, so numeric (3) and alphanumeric (2) character groups are never split between chunks
+  static constexpr size_t FLASH_CHUNK_LENGTH = 24;
+  struct qrcodegen_TextInfo analyzeFlashText(const __FlashStringHelper *text);
+  static size_t readFlashChunk(const char *&flashText, char *chunk);
+  bool acquireBuffers(uint8_t version, uint8_t *&qrcodeBuffer, uint8_t *&tempBuffer);
+  uint8_t* releaseBuffers(bool success, uint8_t *qrcodeBuffer, uint8_t *tempBuffer, uint8_t version);
+  const uint8_t* findInCache(QRCodeCacheKey &key, const uint8_t *payload, size_t length, bool binary, bool payloadInFlash,
+                             uint8_t maxVersion);
+  uint8_t* loadFromCache(const uint8_t *cachedQRCode);
+  uint8_t* addToCache(const QRCodeCacheKey &key, const uint8_t *payload, bool payloadInFlash, uint8_t version);
+  void storeInCache(uint8_t *cacheSlot, bool success, const uint8_t *qrcodeBuffer);
+  bool encodeText(const char *text, const struct qrcodegen_TextInfo &info, uint8_t minVersion, uint8_t maxVersion,
+                  uint8_t *tempBuffer, uint8_t *qrcodeBuffer);
+  bool encodeSegments(const struct qrcodegen_Segment *segments, size_t count, uint8_t minVersion, uint8_t maxVersion,
+                      uint8_t *tempBuffer, uint8_t *qrcodeBuffer);
+  uint8_t* acquireMaskBuffers(uint8_t maxVersion, size_t &size);
+  uint8_t* acquireBuffer(uint8_t *providedBuffer, uint8_t version);
+  void releaseBuffer(uint8_t *providedBuffer, uint8_t *buffer, uint8_t version);
+  // Every heap buffer of a generation goes through these, so the stats can follow heap usage
+  void* allocate(size_t size);
+  void deallocate(void *buffer, size_t size);
+  bool generateBatchItem(QRCodeBatchItem &item, uint8_t *tempBuffer);
+  static void generateBatchTask(size_t index, uint8_t worker, void *context);
+  static void generateAsyncTask(size_t index, uint8_t worker, void *context);
+  static void forwardRow(int y, const uint8_t modules[], int size, void *context);
+  static void emitRows(const uint8_t *qrcode, QRCodeRowSink &sink);
+
 public:
+  // Destructor
+  ~QRCodeGenerator();
+
   // Getters and setters
   QRCodeGenerator& setErrorCorrectionLevel(QRCodeECCLevel level);
   QRCodeECCLevel getErrorCorrectionLevel();
@@ -47,6 +98,35 @@ public:
   QRCodeGenerator& setVersionRange(uint8_t minVersion, uint8_t maxVersion);
   uint8_t getMinVersion();
   uint8_t getMaxVersion();
+  QRCodeGenerator& setMask(QRCodeMask mask);
+  QRCodeMask getMask();
+
+  // All the settings above at once, e.g. to share them with QRCodeConfig::encode() on other threads
+  QRCodeGenerator& setConfig(const QRCodeConfig &config);
+  const QRCodeConfig& getConfig();
+
+  // Keeps generated symbols in the given cache (NULL disables it)
+  // Generating a payload again with the same settings then just copies the cached symbol
+  //   QRCodeCache cache(4096); // byte budget
+  //   generator.setCache(&cache);
+  QRCodeGenerator& setCache(QRCodeCache *cache);
+  QRCodeCache* getCache();
+
+  // Scores the 8 mask patterns concurrently on the executor's workers (NULL scores them one after the other)
+  // Each worker masks its own copy of the grid, so this needs one extra buffer per worker while encoding
+  // Only symbols from minVersion up are worth it: for smaller ones, starting the tasks costs more than scoring
+  //   QRCodeThreadPool pool(4);
+  //   generator.setMaskExecutor(&pool);
+  // The result is always the same symbol as the serial search; batches (generateBatch) always score serially
+  QRCodeGenerator& setMaskExecutor(QRCodeExecutor *executor, uint8_t minVersion = 25);
+  QRCodeExecutor* getMaskExecutor();
+
+#ifdef QRCODE_STATS
+  // Phase timings and counts of the last generateData, endPayload or generateFrom call
+  // Only available when QRCODE_STATS is defined in qrcodegen.h
+  const QRCodeStats& getLastStats();
+#endif
+
   QRCodeGenerator& setBuffers(uint8_t *qrcodeBuffer, uint8_t *tempBuffer, uint16_t size);
   uint8_t* getQRCodeBuffer();
   uint8_t* getTempBuffer();
@@ -57,12 +137,86 @@ public:
   // They are suppressed when using less memory
   uint8_t getMinVersion(const String &text);
   uint8_t getMinVersion(const char* text);
+  uint8_t getMinVersion(const __FlashStringHelper *text);
 
   uint16_t getBufferSize(const String &text);
   uint16_t getBufferSize(const char* text);
+  uint16_t getBufferSize(const __FlashStringHelper *text);
+
+  // Binary data is always encoded in byte mode, so only its length matters
+  uint8_t getMinVersion(const uint8_t *data, size_t length);
+  uint16_t getBufferSize(const uint8_t *data, size_t length);
 #endif
 
   // Generation methods
   uint8_t* generateData(const String &text);
   uint8_t* generateData(const char* text);
+
+  // Text stored in flash with the F() macro, e.g. generateData(F("https://example.com"))
+  // It is read straight from flash, so it doesn't take any RAM while waiting to be encoded
+  uint8_t* generateData(const __FlashStringHelper *text);
+
+  // Binary data may contain zeros and needs no terminator
+  // It is encoded straight from the given array, without being copied
+  uint8_t* generateData(const uint8_t *data, size_t length);
+
+  // Incremental generation: print the payload piece by piece, without building a String
+  // The bytes go straight into the temp buffer and then the qrcode buffer, both sized for maxLength bytes in byte mode
+  // Numeric and alphanumeric payloads may be longer than one buffer (they are packed before encoding),
+  // but those don't use the cache
+  //   QRCodePayloadWriter &payload = generator.beginPayload(64);
+  //   payload.print("ID:");
+  //   payload.print(deviceId);
+  //   uint8_t *data = generator.endPayload();
+  // endPayload returns NULL if the payload was longer than maxLength or didn't fit the version range
+  QRCodePayloadWriter& beginPayload(size_t maxLength);
+  uint8_t* endPayload();
+  void cancelPayload();
+
+  // Reads a payload from a Stream (Serial, File, WiFiClient...) until the terminator
+  // It is collected straight into the generator buffers like beginPayload(), so there's no String or heap copy
+  uint8_t* generateFrom(Stream &stream, char terminator, size_t maxLength);
+
+  // Encodes many texts at once, each into its own output slot, with the current settings (the cache is not used)
+  // The work is spread over the executor's workers, each with its own scratch buffer
+  // NULL runs everything in the calling thread (using the static temp buffer, if provided)
+  // Each item is encoded on its own, so the results never depend on the executor
+  //   QRCodeThreadPool pool;
+  //   generator.generateBatch(items, count, &pool);
+  // Returns true if every item succeeded, otherwise check each item's success flag
+  bool generateBatch(QRCodeBatchItem *items, size_t count, QRCodeExecutor *executor = NULL);
+
+  // Time-sliced generation: encodes a little at a time, so loop() keeps running while a QR Code is generated
+  //   generator.beginGenerate(text);
+  //   ...
+  //   if (generator.step(2000) == 100) { // work for about 2 ms, returns the progress (0 to 100)
+  //     uint8_t *data = generator.endGenerate();
+  //   }
+  // The text is copied when generation begins, but the buffers stay in use until endGenerate
+  // Don't call the other generation methods in between, or call cancelGenerate first
+  // A step takes at least one encoding stage, the longest being one mask trial (see setMask)
+  bool beginGenerate(const String &text);
+  bool beginGenerate(const char* text);
+  uint8_t step(uint32_t budgetMicros);
+  bool isGenerating();
+  // Finishes the remaining stages at once, if any, and returns the data (NULL if nothing was being generated)
+  uint8_t* endGenerate();
+  void cancelGenerate();
+
+  // Generates on the given executor and passes the data to callback (which must free it, like generateData's result)
+  // With QRCodeBackgroundExecutor this returns right away, and the encoding overlaps whatever the caller does next
+  // (e.g. a long e-paper refresh); executors that can't run in the background run it before returning
+  //   void onGenerated(uint8_t *qrcode, void *context) { ... }
+  //   generator.generateAsync(text, executor, onGenerated);
+  // The text is copied, but the generator is in use until callback is called: don't change or use it meanwhile
+  // callback runs on the executor's thread; returns false (without calling it) if the text copy didn't fit in memory
+  bool generateAsync(const String &text, QRCodeExecutor &executor, QRCodeCallback callback, void *context = NULL);
+  bool generateAsync(const char* text, QRCodeExecutor &executor, QRCodeCallback callback, void *context = NULL);
+
+  // Streams the QR Code to sink, each row as soon as the final mask is applied to it, instead of returning the data
+  // The rows are not read back from a finished QR Code, and nothing is kept afterwards: heap buffers are freed,
+  // and static buffers don't hold a valid QR Code (unless a cache is set, which needs the finished QR Code)
+  // Returns false (without calling the sink) if the text doesn't fit or there is not enough memory
+  bool generateRows(const String &text, QRCodeRowSink &sink);
+  bool generateRows(const char* text, QRCodeRowSink &sink);
 };
\ No newline at end of file
@@ -0,0 +1,189 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeModules.h"
+
+static const uint8_t REVERSED_NIBBLES[16] PROGMEM = {
+  0x0, 0x8, 0x4, 0xC, 0x2, 0xA, 0x6, 0xE, 0x1, 0x9, 0x5, 0xD, 0x3, 0xB, 0x7, 0xF
+};
+
+// Passes rows to a callback
+class QRCodeCallbackRowSink : public QRCodeRowSink {
+private:
+  QRCodeRowCallback callback;
+  void *context;
+
+public:
+  QRCodeCallbackRowSink(QRCodeRowCallback callback, void *context) : callback(callback), context(context) {
+  }
+
+  void writeRow(uint8_t y, const uint8_t *modules, uint8_t size) override {
+    callback(y, modules, size, context);
+  }
+};
+
+// Splits rows into runs of dark modules, skipping whole bytes of the same color
+class QRCodeRunRowSink : public QRCodeRowSink {
+private:
+  QRCodeRunCallback callback;
+  void *context;
+
+  static bool isDark(const uint8_t *modules, uint8_t x) {
+    return modules[x >> 3] & (0x80 >> (x & 7));
+  }
+
+public:
+  QRCodeRunRowSink(QRCodeRunCallback callback, void *context) : callback(callback), context(context) {
+  }
+
+  void writeRow(uint8_t y, const uint8_t *modules, uint8_t size) override {
+    uint8_t x = 0;
+    while (x < size) {
+      if ((x & 7) == 0 && modules[x >> 3] == 0x00) {
+        x += 8;
+        continue;
+      }
+      if (!isDark(modules, x)) {
+        x++;
+        continue;
+      }
+      uint8_t start = x;
+      while (x < size) {
+        if ((x & 7) == 0 && x + 8 <= size && modules[x >> 3] == 0xFF) {
+          x += 8;
+        }
+        else if (isDark(modules, x)) {
+          x++;
+        }
+        else {
+          break;
+        }
+      }
+      callback(y, start, x - start, context);
+    }
+  }
+};
+
+// Private methods
+
+uint8_t QRCodeModules::readByte(const uint8_t *qrcode, bool inFlash, int32_t byteIndex, int32_t byteCount) {
+  if (byteIndex < 0 || byteIndex >= byteCount) {
+    return 0;
+  }
+  return inFlash ? pgm_read_byte(qrcode + byteIndex + 1) : qrcode[byteIndex + 1];
+}
+
+uint8_t QRCodeModules::reverseBits(uint8_t bits) {
+  return pgm_read_byte(&REVERSED_NIBBLES[bits & 0x0F]) << 4 | pgm_read_byte(&REVERSED_NIBBLES[bits >> 4]);
+}
+
+bool QRCodeModules::forEachRow(const uint8_t *qrcode, bool inFlash, QRCodeRowSink &sink, QRCodeRotation rotation) {
+  if (qrcode == NULL) {
+    return false;
+  }
+  uint8_t size = inFlash ? pgm_read_byte(qrcode) : qrcode[0];
+  uint8_t last = size - 1;
+
+  // Module (x, y) of the rotated QR Code is at bit start + y * rowStep + x * step of qrcodegen's layout
+  // The comments give the unrotated module it comes from
+  int32_t start, rowStep, step;
+  switch (rotation) {
+    case QRCodeRotation::R90:  // (y, last - x)
+      start = (int32_t)last * size;
+      rowStep = 1;
+      step = -size;
+      break;
+    case QRCodeRotation::R180: // (last - x, last - y)
+      start = (int32_t)last * size + last;
+      rowStep = -size;
+      step = -1;
+      break;
+    case QRCodeRotation::R270: // (last - y, x)
+      start = last;
+      rowStep = -1;
+      step = size;
+      break;
+    default:                   // (x, y)
+      start = 0;
+      rowStep = size;
+      step = 1;
+      break;
+  }
+
+  uint8_t row[(qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8];
+  uint8_t rowBytes = (size + 7) / 8;
+  int32_t byteCount = ((int32_t)size * size + 7) / 8;
+  sink.begin(size);
+  for (uint8_t y = 0; y < size; y++) {
+    int32_t index = start + (int32_t)y * rowStep;
+    if (step == 1 || step == -1) {
+      // R0 and R180: the row is a run of consecutive bits, taken 8 modules at a time
+      for (uint8_t i = 0; i < rowBytes; i++) {
+        int32_t first = step == 1 ? index + i * 8 : index - i * 8 - 7;
+        int32_t byteIndex = first >> 3;
+        uint16_t window = readByte(qrcode, inFlash, byteIndex, byteCount)
+                        | (uint16_t)readByte(qrcode, inFlash, byteIndex + 1, byteCount) << 8;
+        uint8_t bits = window >> (first & 7);
+        // qrcodegen stores the leftmost module in the least significant bit, so R0 reverses the byte
+        row[i] = step == 1 ? reverseBits(bits) : bits;
+      }
+      // Bits past the end of the row belong to the next one
+      row[rowBytes - 1] &= 0xFF << (rowBytes * 8 - size);
+    }
+    else {
+      // R90 and R270: the row is a column of the QR Code, one module per byte of the buffer
+      memset(row, 0, rowBytes);
+      for (uint8_t x = 0; x < size; x++, index += step) {
+        uint8_t modules = inFlash ? pgm_read_byte(qrcode + (index >> 3) + 1) : qrcode[(index >> 3) + 1];
+        if ((modules >> (index & 7)) & 1) {
+          row[x >> 3] |= 0x80 >> (x & 7);
+        }
+      }
+    }
+    sink.writeRow(y, row, size);
+  }
+  sink.end();
+  return true;
+}
+
+bool QRCodeModules::forEachDarkRun(const uint8_t *qrcode, bool inFlash, QRCodeRunCallback callback, void *context,
+                                   QRCodeRotation rotation) {
+  QRCodeRunRowSink sink(callback, context);
+  return forEachRow(qrcode, inFlash, sink, rotation);
+}
+
+// Public methods
+
+bool QRCodeModules::forEachRow(const uint8_t *qrcode, QRCodeRowCallback callback, void *context, QRCodeRotation rotation) {
+  QRCodeCallbackRowSink sink(callback, context);
+  return forEachRow(qrcode, false, sink, rotation);
+}
+
+bool QRCodeModules::forEachRow(const QRCodeStaticData &data, QRCodeRowCallback callback, void *context,
+                               QRCodeRotation rotation) {
+  QRCodeCallbackRowSink sink(callback, context);
+  return forEachRow(data.qrcode, true, sink, rotation);
+}
+
+bool QRCodeModules::forEachRow(const uint8_t *qrcode, QRCodeRowSink &sink, QRCodeRotation rotation) {
+  return forEachRow(qrcode, false, sink, rotation);
+}
+
+bool QRCodeModules::forEachRow(const QRCodeStaticData &data, QRCodeRowSink &sink, QRCodeRotation rotation) {
+  return forEachRow(data.qrcode, true, sink, rotation);
+}
+
+bool QRCodeModules::forEachDarkRun(const uint8_t *qrcode, QRCodeRunCallback callback, void *context,
+                                   QRCodeRotation rotation) {
+  return forEachDarkRun(qrcode, false, callback, context, rotation);
+}
+
+bool QRCodeModules::forEachDarkRun(const QRCodeStaticData &data, QRCodeRunCallback callback, void *context,
+                                   QRCodeRotation rotation) {
+  return forEachDarkRun(data.qrcode, true, callback, context, rotation);
+}
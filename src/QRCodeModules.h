@@ -0,0 +1,59 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "QRCodeRowSink.h"
+#include "QRCodeStatic.h"
+
+enum class QRCodeRotation {
+    R0 = 0,    // 0 degrees
+    R90 = 1,   // 90 degrees
+    R180 = 2,  // 180 degrees
+    R270 = 3   // 270 degrees
+};
+
+// Receives a row of the (rotated) QR Code, leftmost module in the most significant bit of modules[0], 1 for dark
+typedef void (*QRCodeRowCallback)(uint8_t y, const uint8_t *modules, uint8_t size, void *context);
+
+// Receives length dark modules in a row of the (rotated) QR Code, from (x, y) to the right
+typedef void (*QRCodeRunCallback)(uint8_t y, uint8_t x, uint8_t length, void *context);
+
+// Visits the modules of QR Code data (e.g. returned by QRCodeGenerator::generateData) or a static QR Code,
+// for renderers that don't go through Adafruit_GFX: LED matrices, NeoPixel panels, thermal printers...
+// Rows are read straight from the buffer, without qrcodegen_getModule's bounds checks, and can be rotated
+// clockwise on the way. The quiet zone is not included: coordinates go from 0 to size - 1
+//   QRCodeModules::forEachDarkRun(data, [](uint8_t y, uint8_t x, uint8_t length, void *context) {
+//     matrix.drawFastHLine(x, y, length, color);
+//   });
+class QRCodeModules {
+private:
+  static uint8_t readByte(const uint8_t *qrcode, bool inFlash, int32_t byteIndex, int32_t byteCount);
+  static uint8_t reverseBits(uint8_t bits);
+  static bool forEachRow(const uint8_t *qrcode, bool inFlash, QRCodeRowSink &sink, QRCodeRotation rotation);
+  static bool forEachDarkRun(const uint8_t *qrcode, bool inFlash, QRCodeRunCallback callback, void *context,
+                             QRCodeRotation rotation);
+
+public:
+  // Sends the rows top to bottom, packed like QRCodeRowSink rows
+  // Returns false if qrcode is NULL
+  static bool forEachRow(const uint8_t *qrcode, QRCodeRowCallback callback, void *context = NULL,
+                         QRCodeRotation rotation = QRCodeRotation::R0);
+  static bool forEachRow(const QRCodeStaticData &data, QRCodeRowCallback callback, void *context = NULL,
+                         QRCodeRotation rotation = QRCodeRotation::R0);
+  static bool forEachRow(const uint8_t *qrcode, QRCodeRowSink &sink, QRCodeRotation rotation = QRCodeRotation::R0);
+  static bool forEachRow(const QRCodeStaticData &data, QRCodeRowSink &sink, QRCodeRotation rotation = QRCodeRotation::R0);
+
+  // Sends each horizontal run of dark modules, top to bottom and left to right
+  // A run is one call, so a renderer can fill it at once (one line of LEDs, one span of printer dots)
+  static bool forEachDarkRun(const uint8_t *qrcode, QRCodeRunCallback callback, void *context = NULL,
+                             QRCodeRotation rotation = QRCodeRotation::R0);
+  static bool forEachDarkRun(const QRCodeStaticData &data, QRCodeRunCallback callback, void *context = NULL,
+                             QRCodeRotation rotation = QRCodeRotation::R0);
+};
@@ -0,0 +1,119 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodePayloadWriter.h"
+
+// Private methods
+
+uint8_t* QRCodePayloadWriter::getWritePosition(size_t &available) {
+  if (info.length < capacity) {
+    available = capacity - info.length;
+    return buffer + info.length;
+  }
+  size_t spillLength = info.length - capacity;
+  available = spillCapacity - spillLength;
+  return available > 0 ? spillBuffer + spillLength : NULL;
+}
+
+// Public methods
+
+void QRCodePayloadWriter::begin(uint8_t *buffer, size_t capacity, uint8_t *spillBuffer, size_t spillCapacity) {
+  this->buffer = buffer;
+  this->capacity = buffer != NULL ? capacity : 0;
+  this->spillBuffer = spillBuffer;
+  this->spillCapacity = buffer != NULL && spillBuffer != NULL ? spillCapacity : 0;
+  info.length = 0;
+  info.mode = qrcodegen_Mode_NUMERIC;
+  overflow = false;
+}
+
+// Print interface
+
+size_t QRCodePayloadWriter::write(uint8_t byte) {
+  return write(&byte, 1);
+}
+
+size_t QRCodePayloadWriter::write(const uint8_t *data, size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    size_t available;
+    uint8_t *position = getWritePosition(available);
+    if (position == NULL) {
+      overflow = true;
+      break;
+    }
+
+    size_t length = size - written < available ? size - written : available;
+    memcpy(position, data + written, length);
+    qrcodegen_extendTextInfo(&info, (const char *)position, length);
+    written += length;
+  }
+
+  return written;
+}
+
+size_t QRCodePayloadWriter::readFrom(Stream &stream, char terminator) {
+  size_t total = 0;
+  size_t available;
+  uint8_t *position;
+  while ((position = getWritePosition(available)) != NULL) {
+    // Stream copies the bytes straight into the payload buffer
+    size_t size = stream.readBytesUntil(terminator, (char *)position, available);
+    qrcodegen_extendTextInfo(&info, (const char *)position, size);
+    total += size;
+    if (size < available) {
+      return total; // terminator found or stream timed out
+    }
+  }
+
+  // The payload is full, so the terminator might not have been reached yet
+  char next;
+  if (stream.readBytes(&next, 1) == 1 && next != terminator) {
+    char target[2] = {terminator, '\0'};
+    stream.find(target); // discard the rest of the line
+    overflow = true;
+  }
+
+  return total;
+}
+
+size_t QRCodePayloadWriter::copyText(size_t offset, char *text, size_t length) {
+  if (offset >= info.length) {
+    return 0;
+  }
+  if (length > info.length - offset) {
+    length = info.length - offset;
+  }
+
+  for (size_t i = 0; i < length; i++, offset++) {
+    text[i] = offset < capacity ? buffer[offset] : spillBuffer[offset - capacity];
+  }
+  return length;
+}
+
+// Getters
+
+uint8_t* QRCodePayloadWriter::getBuffer() {
+  return buffer;
+}
+
+uint8_t* QRCodePayloadWriter::getSpillBuffer() {
+  return spillBuffer;
+}
+
+size_t QRCodePayloadWriter::getLength() {
+  return info.length;
+}
+
+const struct qrcodegen_TextInfo& QRCodePayloadWriter::getTextInfo() {
+  return info;
+}
+
+bool QRCodePayloadWriter::hasOverflowed() {
+  return overflow;
+}
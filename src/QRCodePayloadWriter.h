@@ -0,0 +1,54 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "qrcodegen.h"
+
+// A Print that collects a QR Code payload straight into the generator buffers
+// Anything you can print (Stream data, numbers, flash strings...) can be part of the payload
+// The text is analyzed while it arrives, so encoding doesn't need to scan it again
+// Get one from QRCodeGenerator::beginPayload() instead of creating it yourself
+class QRCodePayloadWriter : public Print {
+private:
+  uint8_t *buffer = NULL;
+  size_t capacity = 0;
+  uint8_t *spillBuffer = NULL;
+  size_t spillCapacity = 0;
+  struct qrcodegen_TextInfo info = {0, qrcodegen_Mode_NUMERIC};
+  bool overflow = false;
+
+  // Where the next byte goes, and how many bytes fit there (NULL if the payload is full)
+  uint8_t* getWritePosition(size_t &available);
+
+public:
+  // Starts a new payload that will be stored in buffer[0 : capacity], then in spillBuffer[0 : spillCapacity]
+  void begin(uint8_t *buffer, size_t capacity, uint8_t *spillBuffer = NULL, size_t spillCapacity = 0);
+
+  // Print interface
+  size_t write(uint8_t byte) override;
+  size_t write(const uint8_t *data, size_t size) override;
+  using Print::write;
+
+  // Reads the stream into the payload until the terminator (which is consumed but not stored)
+  // Stops at the stream timeout, like Stream::readStringUntil()
+  // If the line doesn't fit, the rest of it is discarded and the payload is marked as overflowed
+  size_t readFrom(Stream &stream, char terminator);
+
+  // Copies up to length bytes of the payload, starting at offset, into text
+  // The payload may be split between both buffers, text gets it in one piece
+  size_t copyText(size_t offset, char *text, size_t length);
+
+  // Getters
+  uint8_t* getBuffer();
+  uint8_t* getSpillBuffer();
+  size_t getLength();
+  const struct qrcodegen_TextInfo& getTextInfo();
+  bool hasOverflowed();
+};
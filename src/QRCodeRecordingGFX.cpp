@@ -0,0 +1,139 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeRecordingGFX.h"
+
+// Cost models
+
+// Each primitive opens an address window (CASET, PASET and RAMWR with their parameters: 11 bytes)
+const QRCodeDisplayModel QRCodeRecordingGFX::ILI9341 = {"ILI9341", 40000000, 8, 2, 11, 2000, 0, 0, 0};
+
+// Pixels go to a 1 KB buffer, sent page by page when display() is called
+const QRCodeDisplayModel QRCodeRecordingGFX::SSD1306 = {"SSD1306", 400000, 9, 0, 0, 300, 150, 1024 + 8, 0};
+
+// Pixels go to a 296x128 / 8 bytes buffer, then the panel takes most of a second to refresh
+const QRCodeDisplayModel QRCodeRecordingGFX::GxEPD2 = {"GxEPD2", 4000000, 8, 0, 0, 300, 150, 4736 + 16, 700000};
+
+// Constructor
+
+QRCodeRecordingGFX::QRCodeRecordingGFX(int16_t width, int16_t height, const QRCodeDisplayModel &model, bool keepPixels)
+  : Adafruit_GFX(width, height), model(model) {
+  if (keepPixels) {
+    framebuffer = (uint16_t *)calloc((size_t)width * height, sizeof(uint16_t));
+  }
+  resetCounters();
+}
+
+// Destructor
+
+QRCodeRecordingGFX::~QRCodeRecordingGFX() {
+  free(framebuffer);
+}
+
+// Adafruit_GFX primitives
+
+void QRCodeRecordingGFX::drawPixel(int16_t x, int16_t y, uint16_t color) {
+  counters.drawPixelCalls++;
+  record(x, y, 1, 1, color);
+}
+
+void QRCodeRecordingGFX::fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  counters.fillRectCalls++;
+  record(x, y, w, h, color);
+}
+
+void QRCodeRecordingGFX::drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) {
+  counters.fastLineCalls++;
+  record(x, y, w, 1, color);
+}
+
+void QRCodeRecordingGFX::drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) {
+  counters.fastLineCalls++;
+  record(x, y, 1, h, color);
+}
+
+void QRCodeRecordingGFX::fillScreen(uint16_t color) {
+  fillRect(0, 0, width(), height(), color);
+}
+
+void QRCodeRecordingGFX::record(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) {
+  // Clip like the drivers do, off-screen pixels are never sent
+  int16_t x1 = x + w;
+  int16_t y1 = y + h;
+  if (x < 0) x = 0;
+  if (y < 0) y = 0;
+  if (x1 > width()) x1 = width();
+  if (y1 > height()) y1 = height();
+  if (x >= x1 || y >= y1) {
+    return;
+  }
+
+  uint32_t pixels = (uint32_t)(x1 - x) * (y1 - y);
+  counters.pixels += pixels;
+  if (model.bytesPerPixel > 0) {
+    counters.busBytes += model.windowBytes + pixels * model.bytesPerPixel;
+    counters.transactions++;
+  }
+
+  if (framebuffer != NULL) {
+    for (int16_t row = y; row < y1; row++) {
+      uint16_t *pixel = framebuffer + (size_t)row * width() + x;
+      for (int16_t column = x; column < x1; column++) {
+        *pixel++ = color;
+      }
+    }
+  }
+}
+
+void QRCodeRecordingGFX::flush() {
+  counters.flushes++;
+  if (model.flushBytes > 0) {
+    counters.busBytes += model.flushBytes;
+    counters.transactions++;
+  }
+}
+
+// Getters
+
+const QRCodeDisplayModel& QRCodeRecordingGFX::getModel() {
+  return model;
+}
+
+const QRCodeRenderCounters& QRCodeRecordingGFX::getCounters() {
+  return counters;
+}
+
+uint32_t QRCodeRecordingGFX::getModelledMicros() {
+  uint32_t calls = counters.drawPixelCalls + counters.fillRectCalls + counters.fastLineCalls;
+  uint64_t nanos = (uint64_t)counters.busBytes * model.bitsPerByte * 1000000000ULL / model.busHz
+                 + (uint64_t)calls * model.callNanos
+                 + (uint64_t)counters.pixels * model.pixelNanos;
+  return (uint32_t)(nanos / 1000) + counters.flushes * model.refreshMicros;
+}
+
+const uint16_t* QRCodeRecordingGFX::getFramebuffer() {
+  return framebuffer;
+}
+
+uint16_t QRCodeRecordingGFX::getPixel(int16_t x, int16_t y) {
+  if (framebuffer == NULL || x < 0 || y < 0 || x >= width() || y >= height()) {
+    return 0;
+  }
+  return framebuffer[(size_t)y * width() + x];
+}
+
+bool QRCodeRecordingGFX::samePixels(QRCodeRecordingGFX &other) {
+  if (framebuffer == NULL || other.framebuffer == NULL || width() != other.width() || height() != other.height()) {
+    return false;
+  }
+  return memcmp(framebuffer, other.framebuffer, (size_t)width() * height() * sizeof(uint16_t)) == 0;
+}
+
+void QRCodeRecordingGFX::resetCounters() {
+  memset(&counters, 0, sizeof(counters));
+}
@@ -0,0 +1,91 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include <Adafruit_GFX.h>
+
+// Rough cost of a display driver, used by QRCodeRecordingGFX to estimate drawing time without hardware
+// The predefined models are estimates from the drivers' code and datasheets, not measurements
+struct QRCodeDisplayModel {
+  const char *name;
+  uint32_t busHz;          // SPI or I2C clock
+  uint8_t bitsPerByte;     // 8 for SPI, 9 for I2C (acknowledge bit)
+  uint8_t bytesPerPixel;   // sent for each pixel, 0 if the driver draws into a RAM buffer
+  uint8_t windowBytes;     // sent before each primitive to set the address window
+  uint16_t callNanos;      // CPU and chip select overhead of each primitive
+  uint16_t pixelNanos;     // CPU time of each pixel written to a RAM buffer
+  uint16_t flushBytes;     // sent by display() for buffered drivers
+  uint32_t refreshMicros;  // panel refresh after display() (e-paper)
+};
+
+// What was sent to a QRCodeRecordingGFX since the last reset
+struct QRCodeRenderCounters {
+  uint32_t drawPixelCalls;
+  uint32_t fillRectCalls;
+  uint32_t fastLineCalls;  // drawFastHLine and drawFastVLine
+  uint32_t pixels;         // pixels touched, counting overdraw
+  uint32_t busBytes;       // bytes sent to the display, according to the model
+  uint32_t transactions;   // primitives sent to the display plus flushes
+  uint32_t flushes;
+};
+
+// A display that only exists in memory: it records every drawing call, keeps the pixels in a framebuffer
+// for exact comparisons, and estimates the time a real driver would take, according to a cost model
+// Use it to compare drawing strategies without hardware, on a host or on a board with enough RAM
+//   QRCodeRecordingGFX display(240, 240, QRCodeRecordingGFX::ILI9341);
+//   QRCodeGFX qrcode(display);
+//   qrcode.draw(text, 0, 0);
+//   display.getModelledMicros();
+class QRCodeRecordingGFX : public Adafruit_GFX {
+private:
+  QRCodeDisplayModel model;
+  uint16_t *framebuffer = NULL;
+  QRCodeRenderCounters counters;
+
+  void record(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color);
+
+public:
+  // Cost models of common drivers
+  static const QRCodeDisplayModel ILI9341;  // Adafruit_ILI9341, SPI at 40 MHz, 16 bits per pixel
+  static const QRCodeDisplayModel SSD1306;  // Adafruit_SSD1306 128x64, buffered, I2C at 400 kHz
+  static const QRCodeDisplayModel GxEPD2;   // GxEPD2 2.9'' black and white, buffered, SPI at 4 MHz, partial refresh
+
+  // Constructor
+  // The framebuffer takes 2 bytes per pixel; without it (or if it can't be allocated) calls are still counted
+  QRCodeRecordingGFX(int16_t width, int16_t height, const QRCodeDisplayModel &model = ILI9341, bool keepPixels = true);
+
+  // Destructor
+  ~QRCodeRecordingGFX();
+
+  QRCodeRecordingGFX(const QRCodeRecordingGFX&) = delete;
+  QRCodeRecordingGFX& operator=(const QRCodeRecordingGFX&) = delete;
+
+  // Adafruit_GFX primitives
+  void drawPixel(int16_t x, int16_t y, uint16_t color) override;
+  void fillRect(int16_t x, int16_t y, int16_t w, int16_t h, uint16_t color) override;
+  void drawFastHLine(int16_t x, int16_t y, int16_t w, uint16_t color) override;
+  void drawFastVLine(int16_t x, int16_t y, int16_t h, uint16_t color) override;
+  void fillScreen(uint16_t color) override;
+
+  // Same as display() on buffered drivers: counts the buffer transfer and the panel refresh
+  void flush();
+
+  // Getters
+  const QRCodeDisplayModel& getModel();
+  const QRCodeRenderCounters& getCounters();
+  uint32_t getModelledMicros();
+  const uint16_t* getFramebuffer();
+  uint16_t getPixel(int16_t x, int16_t y);
+
+  // True if both have the same size and pixels (false if either has no framebuffer)
+  bool samePixels(QRCodeRecordingGFX &other);
+
+  void resetCounters();
+};
@@ -0,0 +1,28 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+
+// Receives a QR Code row by row, as the encoder finishes each one (see QRCodeGenerator::generateRows)
+// Rows come top to bottom, in module coordinates: scaling, rotation and colors are up to the sink
+class QRCodeRowSink {
+public:
+  virtual ~QRCodeRowSink() {}
+
+  // Called before the first row, with the number of modules per side
+  virtual void begin(uint8_t size) {}
+
+  // modules holds the row, with the leftmost module in the most significant bit of modules[0]
+  // A set bit is a dark module. The array is only valid during the call
+  virtual void writeRow(uint8_t y, const uint8_t *modules, uint8_t size) = 0;
+
+  // Called after the last row
+  virtual void end() {}
+};
@@ -0,0 +1,19 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+// QRCode minimum version detection is computed from the QR Code standard tables
+// Those tables are kept in flash memory on AVR boards, so detection costs no RAM, even on an Arduino Uno
+// If you still want to skip it, define QRCODE_GENERATOR_USE_LESS_MEMORY here (uncomment the line below)
+// This will disable version detection and some methods at compile time, saving a little program space
+// In that case, you must set the version range according to your device capabilities
+// Please check the text size limits for each version at the link below
+// https://github.com/ricmoo/QRCode/tree/master?tab=readme-ov-file#data-capacities
+
+//#define QRCODE_GENERATOR_USE_LESS_MEMORY
@@ -0,0 +1,605 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include <limits.h>
+#include "qrcodegen.h"
+#include "QRCodeGenerator.h"
+
+// A finished QR Code stored in flash memory (in qrcodegen layout: size byte followed by the modules)
+// Draw it with QRCodeGFX::draw(const QRCodeStaticData&, x, y)
+struct QRCodeStaticData {
+  const uint8_t *qrcode;
+};
+
+// Compile-time encoding needs C++14 constexpr functions (loops and local variables)
+// ESP32, RP2040 and most ARM cores build with C++14 or newer
+// The classic AVR core builds with -std=gnu++11, so there you must add -std=gnu++14 to the compiler flags
+#if __cplusplus >= 201402L
+
+#define QRCODE_STATIC_ENABLED
+
+// A QR Code encoded by the compiler, see QRCODE_STATIC below
+template <int VERSION>
+struct QRCodeStatic {
+  uint8_t qrcode[qrcodegen_BUFFER_LEN_FOR_VERSION(VERSION)];
+
+  operator QRCodeStaticData() const {
+    return QRCodeStaticData{qrcode};
+  }
+};
+
+// Encodes a string literal (or any constexpr string) at compile time, producing the same symbol as QRCodeGenerator
+// Keep the result in flash with PROGMEM, so the constant case costs no encoding time and no RAM:
+//   static constexpr auto supportQRCode PROGMEM = QRCODE_STATIC("https://example.com/help", QRCodeECCLevel::Low);
+//   qrcode.draw(supportQRCode, 10, 10);
+// Large payloads may exceed the compiler's constexpr evaluation limits (see -fconstexpr-ops-limit)
+#define QRCODE_STATIC(text, eccLevel) \
+  QRCodeStaticEncoder::encode<QRCodeStaticEncoder::getVersion((text), (eccLevel))>((text), (eccLevel))
+
+// A constexpr port of the qrcodegen steps used by QRCodeGenerator (one segment in the narrowest mode, automatic mask)
+class QRCodeStaticEncoder {
+public:
+  // Smallest version that fits the text, or 0 if it doesn't fit any version
+  static constexpr int getVersion(const char *text, QRCodeECCLevel eccLevel) {
+    size_t length = getLength(text);
+    int mode = getMode(text);
+    for (int version = qrcodegen_VERSION_MIN; version <= qrcodegen_VERSION_MAX; version++) {
+      if (getTotalBits(mode, length, version) <= getNumDataCodewords(version, (int)eccLevel) * 8) {
+        return version;
+      }
+    }
+    return 0;
+  }
+
+  template <int VERSION>
+  static constexpr QRCodeStatic<VERSION> encode(const char *text, QRCodeECCLevel eccLevel) {
+    static_assert(VERSION >= qrcodegen_VERSION_MIN, "QRCODE_STATIC: text too long for a QR Code");
+
+    int ecl = (int)eccLevel;
+    size_t length = getLength(text);
+    int mode = getMode(text);
+
+    // Data bit string, followed by terminator and padding
+    uint8_t data[qrcodegen_BUFFER_LEN_FOR_VERSION(VERSION)] = {};
+    int bitLength = 0;
+    if (length > 0) {
+      appendBits(mode, 4, data, bitLength);
+      appendBits(length, getCharCountBits(mode, VERSION), data, bitLength);
+      appendText(mode, text, length, data, bitLength);
+    }
+    int dataCapacityBits = getNumDataCodewords(VERSION, ecl) * 8;
+    int terminatorBits = dataCapacityBits - bitLength < 4 ? dataCapacityBits - bitLength : 4;
+    appendBits(0, terminatorBits, data, bitLength);
+    appendBits(0, (8 - bitLength % 8) % 8, data, bitLength);
+    for (uint8_t padByte = 0xEC; bitLength < dataCapacityBits; padByte ^= 0xEC ^ 0x11) {
+      appendBits(padByte, 8, data, bitLength);
+    }
+
+    uint8_t codewords[qrcodegen_BUFFER_LEN_FOR_VERSION(VERSION)] = {};
+    addEccAndInterleave(data, VERSION, ecl, codewords);
+
+    QRCodeStatic<VERSION> result = {};
+    uint8_t *qrcode = result.qrcode;
+    uint8_t functionModules[qrcodegen_BUFFER_LEN_FOR_VERSION(VERSION)] = {};
+    initializeFunctionModules(VERSION, qrcode);
+    drawCodewords(codewords, getNumRawDataModules(VERSION) / 8, qrcode);
+    drawLightFunctionModules(VERSION, qrcode);
+    initializeFunctionModules(VERSION, functionModules);
+
+    int mask = 0;
+    long minPenalty = 0;
+    for (int i = 0; i < 8; i++) {
+      applyMask(functionModules, qrcode, i);
+      drawFormatBits(ecl, i, qrcode);
+      long penalty = getPenaltyScore(qrcode);
+      if (i == 0 || penalty < minPenalty) {
+        mask = i;
+        minPenalty = penalty;
+      }
+      applyMask(functionModules, qrcode, i); // undoes the mask due to XOR
+    }
+    applyMask(functionModules, qrcode, mask);
+    drawFormatBits(ecl, mask, qrcode);
+
+    return result;
+  }
+
+private:
+  // Text analysis
+
+  static constexpr uint8_t NOT_ALPHANUMERIC = 255;
+
+  static constexpr uint8_t getAlphanumericIndex(char c) {
+    if ('0' <= c && c <= '9') return c - '0';
+    if ('A' <= c && c <= 'Z') return c - 'A' + 10;
+    switch (c) {
+      case ' ': return 36;
+      case '$': return 37;
+      case '%': return 38;
+      case '*': return 39;
+      case '+': return 40;
+      case '-': return 41;
+      case '.': return 42;
+      case '/': return 43;
+      case ':': return 44;
+      default:  return NOT_ALPHANUMERIC;
+    }
+  }
+
+  static constexpr size_t getLength(const char *text) {
+    size_t length = 0;
+    while (text[length] != '\0') {
+      length++;
+    }
+    return length;
+  }
+
+  static constexpr int getMode(const char *text) {
+    int mode = qrcodegen_Mode_NUMERIC;
+    for (size_t i = 0; text[i] != '\0'; i++) {
+      uint8_t index = getAlphanumericIndex(text[i]);
+      if (index == NOT_ALPHANUMERIC) {
+        return qrcodegen_Mode_BYTE;
+      }
+      if (index >= 10) {
+        mode = qrcodegen_Mode_ALPHANUMERIC;
+      }
+    }
+    return mode;
+  }
+
+  // QR Code standard tables
+
+  static constexpr int getEccCodewordsPerBlock(int ecl, int version) {
+    constexpr int8_t table[4][41] = {
+      {-1,  7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28, 28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30}, // Low
+      {-1, 10, 16, 26, 18, 24, 16, 18, 22, 22, 26, 30, 22, 22, 24, 24, 28, 28, 26, 26, 26, 26, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28, 28}, // Medium
+      {-1, 13, 22, 18, 26, 18, 24, 18, 22, 20, 24, 28, 26, 24, 20, 30, 24, 28, 28, 26, 30, 28, 30, 30, 30, 30, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30}, // Quartile
+      {-1, 17, 28, 22, 16, 22, 28, 26, 26, 24, 28, 24, 28, 22, 24, 24, 30, 28, 28, 26, 28, 30, 24, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30}, // High
+    };
+    return table[ecl][version];
+  }
+
+  static constexpr int getNumErrorCorrectionBlocks(int ecl, int version) {
+    constexpr int8_t table[4][41] = {
+      {-1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4,  4,  4,  4,  4,  6,  6,  6,  6,  7,  8,  8,  9,  9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25}, // Low
+      {-1, 1, 1, 1, 2, 2, 4, 4, 4, 5, 5,  5,  8,  9,  9, 10, 10, 11, 13, 14, 16, 17, 17, 18, 20, 21, 23, 25, 26, 28, 29, 31, 33, 35, 37, 38, 40, 43, 45, 47, 49}, // Medium
+      {-1, 1, 1, 2, 2, 4, 4, 6, 6, 8, 8,  8, 10, 12, 16, 12, 17, 16, 18, 21, 20, 23, 23, 25, 27, 29, 34, 34, 35, 38, 40, 43, 45, 48, 51, 53, 56, 59, 62, 65, 68}, // Quartile
+      {-1, 1, 1, 2, 4, 4, 4, 5, 6, 8, 8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25, 25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81}, // High
+    };
+    return table[ecl][version];
+  }
+
+  static constexpr int getCharCountBits(int mode, int version) {
+    constexpr uint8_t table[3][3] = {
+      {10, 12, 14}, // Numeric
+      { 9, 11, 13}, // Alphanumeric
+      { 8, 16, 16}, // Byte
+    };
+    int row = mode == qrcodegen_Mode_NUMERIC ? 0 : mode == qrcodegen_Mode_ALPHANUMERIC ? 1 : 2;
+    return table[row][(version + 7) / 17];
+  }
+
+  static constexpr int getNumRawDataModules(int version) {
+    int result = (16 * version + 128) * version + 64;
+    if (version >= 2) {
+      int numAlign = version / 7 + 2;
+      result -= (25 * numAlign - 10) * numAlign - 55;
+      if (version >= 7) {
+        result -= 36;
+      }
+    }
+    return result;
+  }
+
+  static constexpr int getNumDataCodewords(int version, int ecl) {
+    return getNumRawDataModules(version) / 8 - getEccCodewordsPerBlock(ecl, version) * getNumErrorCorrectionBlocks(ecl, version);
+  }
+
+  // Bit string
+
+  static constexpr long getTotalBits(int mode, size_t length, int version) {
+    if (length == 0) {
+      return 0; // no segment at all
+    }
+    int ccbits = getCharCountBits(mode, version);
+    if (length >= (1UL << ccbits)) {
+      return LONG_MAX;
+    }
+    long dataBits = mode == qrcodegen_Mode_NUMERIC ? ((long)length * 10 + 2) / 3
+                  : mode == qrcodegen_Mode_ALPHANUMERIC ? ((long)length * 11 + 1) / 2
+                  : (long)length * 8;
+    return 4 + ccbits + dataBits;
+  }
+
+  static constexpr void appendBits(unsigned long value, int numBits, uint8_t buffer[], int &bitLength) {
+    for (int i = numBits - 1; i >= 0; i--, bitLength++) {
+      buffer[bitLength >> 3] |= ((value >> i) & 1) << (7 - (bitLength & 7));
+    }
+  }
+
+  static constexpr void appendText(int mode, const char *text, size_t length, uint8_t buffer[], int &bitLength) {
+    if (mode == qrcodegen_Mode_NUMERIC) {
+      size_t i = 0;
+      for (; i + 3 <= length; i += 3) {
+        appendBits((text[i] - '0') * 100 + (text[i + 1] - '0') * 10 + (text[i + 2] - '0'), 10, buffer, bitLength);
+      }
+      if (length - i == 2) {
+        appendBits((text[i] - '0') * 10 + (text[i + 1] - '0'), 7, buffer, bitLength);
+      }
+      else if (length - i == 1) {
+        appendBits(text[i] - '0', 4, buffer, bitLength);
+      }
+    }
+    else if (mode == qrcodegen_Mode_ALPHANUMERIC) {
+      size_t i = 0;
+      for (; i + 2 <= length; i += 2) {
+        appendBits(getAlphanumericIndex(text[i]) * 45 + getAlphanumericIndex(text[i + 1]), 11, buffer, bitLength);
+      }
+      if (i < length) {
+        appendBits(getAlphanumericIndex(text[i]), 6, buffer, bitLength);
+      }
+    }
+    else {
+      for (size_t i = 0; i < length; i++) {
+        appendBits((uint8_t)text[i], 8, buffer, bitLength);
+      }
+    }
+  }
+
+  // Error correction
+
+  static constexpr uint8_t reedSolomonMultiply(uint8_t x, uint8_t y) {
+    uint8_t z = 0;
+    for (int i = 7; i >= 0; i--) {
+      z = (uint8_t)((z << 1) ^ ((z >> 7) * 0x11D));
+      z ^= ((y >> i) & 1) * x;
+    }
+    return z;
+  }
+
+  static constexpr void addEccAndInterleave(const uint8_t data[], int version, int ecl, uint8_t result[]) {
+    int numBlocks = getNumErrorCorrectionBlocks(ecl, version);
+    int blockEccLength = getEccCodewordsPerBlock(ecl, version);
+    int rawCodewords = getNumRawDataModules(version) / 8;
+    int dataLength = getNumDataCodewords(version, ecl);
+    int numShortBlocks = numBlocks - rawCodewords % numBlocks;
+    int shortBlockDataLength = rawCodewords / numBlocks - blockEccLength;
+
+    // Generator polynomial, without the leading term
+    uint8_t divisor[30] = {};
+    divisor[blockEccLength - 1] = 1;
+    uint8_t root = 1;
+    for (int i = 0; i < blockEccLength; i++) {
+      for (int j = 0; j < blockEccLength; j++) {
+        divisor[j] = reedSolomonMultiply(divisor[j], root);
+        if (j + 1 < blockEccLength) {
+          divisor[j] ^= divisor[j + 1];
+        }
+      }
+      root = reedSolomonMultiply(root, 0x02);
+    }
+
+    const uint8_t *block = data;
+    for (int i = 0; i < numBlocks; i++) {
+      int blockDataLength = shortBlockDataLength + (i < numShortBlocks ? 0 : 1);
+
+      uint8_t ecc[30] = {};
+      for (int j = 0; j < blockDataLength; j++) {
+        uint8_t factor = block[j] ^ ecc[0];
+        for (int k = 0; k + 1 < blockEccLength; k++) {
+          ecc[k] = ecc[k + 1];
+        }
+        ecc[blockEccLength - 1] = 0;
+        for (int k = 0; k < blockEccLength; k++) {
+          ecc[k] ^= reedSolomonMultiply(divisor[k], factor);
+        }
+      }
+
+      for (int j = 0, k = i; j < blockDataLength; j++, k += numBlocks) {
+        if (j == shortBlockDataLength) {
+          k -= numShortBlocks;
+        }
+        result[k] = block[j];
+      }
+      for (int j = 0, k = dataLength + i; j < blockEccLength; j++, k += numBlocks) {
+        result[k] = ecc[j];
+      }
+      block += blockDataLength;
+    }
+  }
+
+  // Modules
+
+  static constexpr bool getModule(const uint8_t qrcode[], int x, int y) {
+    int index = y * qrcode[0] + x;
+    return ((qrcode[(index >> 3) + 1] >> (index & 7)) & 1) != 0;
+  }
+
+  static constexpr void setModule(uint8_t qrcode[], int x, int y, bool dark) {
+    int size = qrcode[0];
+    if (x < 0 || x >= size || y < 0 || y >= size) {
+      return;
+    }
+    int index = y * size + x;
+    if (dark) {
+      qrcode[(index >> 3) + 1] |= 1 << (index & 7);
+    }
+    else {
+      qrcode[(index >> 3) + 1] &= (1 << (index & 7)) ^ 0xFF;
+    }
+  }
+
+  static constexpr void fillRectangle(int left, int top, int width, int height, uint8_t qrcode[]) {
+    for (int dy = 0; dy < height; dy++) {
+      for (int dx = 0; dx < width; dx++) {
+        setModule(qrcode, left + dx, top + dy, true);
+      }
+    }
+  }
+
+  static constexpr int getAlignmentPatternPositions(int version, uint8_t result[7]) {
+    if (version == 1) {
+      return 0;
+    }
+    int numAlign = version / 7 + 2;
+    int step = (version * 8 + numAlign * 3 + 5) / (numAlign * 4 - 4) * 2;
+    for (int i = numAlign - 1, position = version * 4 + 10; i >= 1; i--, position -= step) {
+      result[i] = (uint8_t)position;
+    }
+    result[0] = 6;
+    return numAlign;
+  }
+
+  static constexpr bool isFinderCorner(int i, int j, int numAlign) {
+    return (i == 0 && j == 0) || (i == 0 && j == numAlign - 1) || (i == numAlign - 1 && j == 0);
+  }
+
+  // Marks every function module as dark, on a light grid
+  static constexpr void initializeFunctionModules(int version, uint8_t qrcode[]) {
+    int size = version * 4 + 17;
+    for (int i = 0; i < qrcodegen_BUFFER_LEN_FOR_VERSION(version); i++) {
+      qrcode[i] = 0;
+    }
+    qrcode[0] = (uint8_t)size;
+
+    fillRectangle(6, 0, 1, size, qrcode);
+    fillRectangle(0, 6, size, 1, qrcode);
+    fillRectangle(0, 0, 9, 9, qrcode);
+    fillRectangle(size - 8, 0, 8, 9, qrcode);
+    fillRectangle(0, size - 8, 9, 8, qrcode);
+
+    uint8_t alignPositions[7] = {};
+    int numAlign = getAlignmentPatternPositions(version, alignPositions);
+    for (int i = 0; i < numAlign; i++) {
+      for (int j = 0; j < numAlign; j++) {
+        if (!isFinderCorner(i, j, numAlign)) {
+          fillRectangle(alignPositions[i] - 2, alignPositions[j] - 2, 5, 5, qrcode);
+        }
+      }
+    }
+
+    if (version >= 7) {
+      fillRectangle(size - 11, 0, 3, 6, qrcode);
+      fillRectangle(0, size - 11, 6, 3, qrcode);
+    }
+  }
+
+  // Draws the light parts of the function patterns and the version blocks
+  static constexpr void drawLightFunctionModules(int version, uint8_t qrcode[]) {
+    int size = qrcode[0];
+    for (int i = 7; i < size - 7; i += 2) {
+      setModule(qrcode, 6, i, false);
+      setModule(qrcode, i, 6, false);
+    }
+
+    for (int dy = -4; dy <= 4; dy++) {
+      for (int dx = -4; dx <= 4; dx++) {
+        int distance = dx < 0 ? -dx : dx;
+        if ((dy < 0 ? -dy : dy) > distance) {
+          distance = dy < 0 ? -dy : dy;
+        }
+        if (distance == 2 || distance == 4) {
+          setModule(qrcode, 3 + dx, 3 + dy, false);
+          setModule(qrcode, size - 4 + dx, 3 + dy, false);
+          setModule(qrcode, 3 + dx, size - 4 + dy, false);
+        }
+      }
+    }
+
+    uint8_t alignPositions[7] = {};
+    int numAlign = getAlignmentPatternPositions(version, alignPositions);
+    for (int i = 0; i < numAlign; i++) {
+      for (int j = 0; j < numAlign; j++) {
+        if (isFinderCorner(i, j, numAlign)) {
+          continue;
+        }
+        for (int dy = -1; dy <= 1; dy++) {
+          for (int dx = -1; dx <= 1; dx++) {
+            setModule(qrcode, alignPositions[i] + dx, alignPositions[j] + dy, dx == 0 && dy == 0);
+          }
+        }
+      }
+    }
+
+    if (version >= 7) {
+      int remainder = version;
+      for (int i = 0; i < 12; i++) {
+        remainder = (remainder << 1) ^ ((remainder >> 11) * 0x1F25);
+      }
+      long bits = (long)version << 12 | remainder;
+      for (int i = 0; i < 6; i++) {
+        for (int j = 0; j < 3; j++) {
+          int k = size - 11 + j;
+          setModule(qrcode, k, i, (bits & 1) != 0);
+          setModule(qrcode, i, k, (bits & 1) != 0);
+          bits >>= 1;
+        }
+      }
+    }
+  }
+
+  static constexpr void drawFormatBits(int ecl, int mask, uint8_t qrcode[]) {
+    int data = (ecl ^ 1) << 3 | mask; // Low, Medium, Quartile, High are encoded as 1, 0, 3, 2
+    int remainder = data;
+    for (int i = 0; i < 10; i++) {
+      remainder = (remainder << 1) ^ ((remainder >> 9) * 0x537);
+    }
+    int bits = (data << 10 | remainder) ^ 0x5412;
+
+    for (int i = 0; i <= 5; i++) {
+      setModule(qrcode, 8, i, (bits >> i) & 1);
+    }
+    setModule(qrcode, 8, 7, (bits >> 6) & 1);
+    setModule(qrcode, 8, 8, (bits >> 7) & 1);
+    setModule(qrcode, 7, 8, (bits >> 8) & 1);
+    for (int i = 9; i < 15; i++) {
+      setModule(qrcode, 14 - i, 8, (bits >> i) & 1);
+    }
+
+    int size = qrcode[0];
+    for (int i = 0; i < 8; i++) {
+      setModule(qrcode, size - 1 - i, 8, (bits >> i) & 1);
+    }
+    for (int i = 8; i < 15; i++) {
+      setModule(qrcode, 8, size - 15 + i, (bits >> i) & 1);
+    }
+    setModule(qrcode, 8, size - 8, true);
+  }
+
+  // Zigzag scan over the non-function modules (which must be light)
+  static constexpr void drawCodewords(const uint8_t data[], int dataLength, uint8_t qrcode[]) {
+    int size = qrcode[0];
+    int i = 0;
+    for (int right = size - 1; right >= 1; right -= 2) {
+      if (right == 6) {
+        right = 5;
+      }
+      for (int vertical = 0; vertical < size; vertical++) {
+        for (int j = 0; j < 2; j++) {
+          int x = right - j;
+          bool upward = ((right + 1) & 2) == 0;
+          int y = upward ? size - 1 - vertical : vertical;
+          if (!getModule(qrcode, x, y) && i < dataLength * 8) {
+            setModule(qrcode, x, y, (data[i >> 3] >> (7 - (i & 7))) & 1);
+            i++;
+          }
+        }
+      }
+    }
+  }
+
+  static constexpr void applyMask(const uint8_t functionModules[], uint8_t qrcode[], int mask) {
+    int size = qrcode[0];
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        if (getModule(functionModules, x, y)) {
+          continue;
+        }
+        bool invert = false;
+        switch (mask) {
+          case 0: invert = (x + y) % 2 == 0;                   break;
+          case 1: invert = y % 2 == 0;                         break;
+          case 2: invert = x % 3 == 0;                         break;
+          case 3: invert = (x + y) % 3 == 0;                   break;
+          case 4: invert = (x / 3 + y / 2) % 2 == 0;           break;
+          case 5: invert = x * y % 2 + x * y % 3 == 0;         break;
+          case 6: invert = (x * y % 2 + x * y % 3) % 2 == 0;   break;
+          case 7: invert = ((x + y) % 2 + x * y % 3) % 2 == 0; break;
+        }
+        setModule(qrcode, x, y, getModule(qrcode, x, y) ^ invert);
+      }
+    }
+  }
+
+  // Mask penalty (same rules and weights as qrcodegen)
+
+  static constexpr void addRunToHistory(int runLength, int history[7], int size) {
+    if (history[0] == 0) {
+      runLength += size; // light border before the first run
+    }
+    for (int i = 6; i > 0; i--) {
+      history[i] = history[i - 1];
+    }
+    history[0] = runLength;
+  }
+
+  static constexpr int countFinderPatterns(const int history[7]) {
+    int n = history[1];
+    bool core = n > 0 && history[2] == n && history[3] == n * 3 && history[4] == n && history[5] == n;
+    return (core && history[0] >= n * 4 && history[6] >= n ? 1 : 0)
+         + (core && history[6] >= n * 4 && history[0] >= n ? 1 : 0);
+  }
+
+  static constexpr long getLinePenalty(const uint8_t qrcode[], int line, bool vertical) {
+    int size = qrcode[0];
+    long result = 0;
+    bool runColor = false;
+    int runLength = 0;
+    int history[7] = {};
+    for (int i = 0; i < size; i++) {
+      bool color = vertical ? getModule(qrcode, line, i) : getModule(qrcode, i, line);
+      if (color == runColor) {
+        runLength++;
+        if (runLength == 5) {
+          result += 3;
+        }
+        else if (runLength > 5) {
+          result++;
+        }
+      }
+      else {
+        addRunToHistory(runLength, history, size);
+        if (!runColor) {
+          result += countFinderPatterns(history) * 40;
+        }
+        runColor = color;
+        runLength = 1;
+      }
+    }
+    if (runColor) {
+      addRunToHistory(runLength, history, size);
+      runLength = 0;
+    }
+    addRunToHistory(runLength + size, history, size); // light border after the last run
+    return result + countFinderPatterns(history) * 40;
+  }
+
+  static constexpr long getPenaltyScore(const uint8_t qrcode[]) {
+    int size = qrcode[0];
+    long result = 0;
+    for (int i = 0; i < size; i++) {
+      result += getLinePenalty(qrcode, i, false) + getLinePenalty(qrcode, i, true);
+    }
+
+    for (int y = 0; y < size - 1; y++) {
+      for (int x = 0; x < size - 1; x++) {
+        bool color = getModule(qrcode, x, y);
+        if (color == getModule(qrcode, x + 1, y) && color == getModule(qrcode, x, y + 1) && color == getModule(qrcode, x + 1, y + 1)) {
+          result += 3;
+        }
+      }
+    }
+
+    int dark = 0;
+    for (int y = 0; y < size; y++) {
+      for (int x = 0; x < size; x++) {
+        dark += getModule(qrcode, x, y);
+      }
+    }
+    int total = size * size;
+    long difference = dark * 20L - total * 10L;
+    int k = (int)(((difference < 0 ? -difference : difference) + total - 1) / total) - 1;
+    return result + k * 10;
+  }
+};
+
+#endif
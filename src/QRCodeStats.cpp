@@ -0,0 +1,119 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#include "QRCodeStats.h"
+
+#ifdef QRCODE_STATS
+
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#elif defined(__GLIBC__)
+#include <pthread.h>
+#endif
+
+#define STACK_PAINT 0xA5
+
+// Left unpainted below the paint() frame, so it never overwrites its own locals
+// Hosts need more because leaf functions may use up to 128 bytes below the stack pointer
+#ifdef ARDUINO
+#define STACK_MARGIN 32
+#else
+#define STACK_MARGIN 256
+#define STACK_HOST_WINDOW 16384
+#endif
+
+#if !defined(ARDUINO) && defined(__GLIBC__)
+// Lowest usable address of the calling thread's stack, or NULL if it can't be found
+static uint8_t* hostStackStart() {
+  pthread_attr_t attributes;
+  if (pthread_getattr_np(pthread_self(), &attributes) != 0) {
+    return NULL; // error: no attributes for this thread
+  }
+
+  void *start = NULL;
+  size_t size = 0;
+  size_t guardSize = 0;
+  bool found = pthread_attr_getstack(&attributes, &start, &size) == 0 &&
+               pthread_attr_getguardsize(&attributes, &guardSize) == 0;
+  pthread_attr_destroy(&attributes);
+  if (!found || start == NULL) {
+    return NULL; // error: stack bounds unknown
+  }
+  return (uint8_t *)start + guardSize; // skip the guard page, in case it's counted in the stack
+}
+#endif
+
+#ifdef __AVR__
+extern char __heap_start;
+extern char *__brkval;
+
+static uint8_t* heapEnd() {
+  return (uint8_t *)(__brkval != 0 ? __brkval : &__heap_start);
+}
+#endif
+
+// Stack probe methods
+// They read and write below the stack pointer on purpose, so they are kept out of inlining and sanitizers
+
+__attribute__((noinline, no_sanitize_address))
+void QRCodeStackProbe::paint() {
+  top = (uint8_t *)__builtin_frame_address(0);
+#if defined(__AVR__)
+  bottom = heapEnd();
+#elif defined(ESP32)
+  bottom = (uint8_t *)pxTaskGetStackStart(NULL) + 64; // the end of the stack may hold a watchpoint
+#elif !defined(ARDUINO) && defined(__GLIBC__)
+  bottom = hostStackStart();
+  if (bottom == NULL || bottom >= top - STACK_MARGIN) {
+    bottom = NULL;
+    return;
+  }
+  if (top - bottom > STACK_HOST_WINDOW) {
+    bottom = top - STACK_HOST_WINDOW;
+  }
+#else
+  bottom = NULL;
+  return;
+#endif
+
+  volatile uint8_t *end = top - STACK_MARGIN;
+  for (volatile uint8_t *p = bottom; p < end; p++) {
+    *p = STACK_PAINT;
+  }
+}
+
+__attribute__((noinline, no_sanitize_address))
+uint32_t QRCodeStackProbe::measure() {
+  capped = false;
+  if (bottom == NULL) {
+    return 0;
+  }
+
+  volatile uint8_t *p = bottom;
+#ifdef __AVR__
+  if (heapEnd() > bottom) {
+    p = heapEnd(); // the heap grew into the painted area
+  }
+#endif
+  volatile uint8_t *end = top - STACK_MARGIN;
+  // The lowest painted byte changed: the stack went at least that far, maybe further
+  capped = p < end && *p != STACK_PAINT;
+  while (p < end && *p == STACK_PAINT) {
+    p++;
+  }
+
+  // Usage that never went past the margin can't be told apart from no usage at all
+  return p < end ? (uint32_t)(top - p) : 0;
+}
+
+bool QRCodeStackProbe::isCapped() {
+  return capped;
+}
+
+#endif
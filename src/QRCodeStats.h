@@ -0,0 +1,98 @@
+/*************************************************
+
+Copyright © 2025 Jan K. S.
+MIT License
+https://github.com/wallysalami/QRCodeGFX
+
+*************************************************/
+
+#pragma once
+
+#include <Arduino.h>
+#include "qrcodegen.h"
+
+// Instrumentation is enabled by defining QRCODE_STATS in qrcodegen.h
+// Without it, none of this (nor getLastStats) is compiled
+#ifdef QRCODE_STATS
+
+// What the last generation (and, for QRCodeGFX, the last drawing) took
+// All times are in microseconds
+struct QRCodeStats {
+  // Encoding phases, see qrcodegen_Stats for details
+  struct qrcodegen_Stats encode;
+
+  // Whole generation call, including the phases above, buffers and cache
+  uint32_t generateMicros;
+  uint32_t allocatedBytes;  // heap only, static buffers are not counted
+  uint16_t allocations;
+  uint32_t heapBytes;       // allocated by the generation and still in use at its end (the QR Code data)
+  uint32_t peakHeapBytes;   // most heap the generation held at once
+  uint32_t stackBytes;      // peak stack below the generation method (0 if it can't be measured)
+  bool stackCapped;         // stackBytes reached the end of the painted area, the real peak is higher
+
+  // Drawing (QRCodeGFX only)
+  uint32_t drawMicros;
+  uint32_t displayCalls;    // drawPixel and fillRect calls sent to the display
+  uint32_t drawStackBytes;  // peak stack below the drawing method
+  bool drawStackCapped;     // same as stackCapped, for drawStackBytes
+};
+
+// Measures the peak stack usage of an operation: paint() fills the free stack below the caller with a
+// known pattern, and measure() looks for the deepest byte that changed since then
+// The painted area ends at the heap on AVR, at the task's stack limit on ESP32, and on glibc hosts
+// 16 KB down or at the thread's stack limit, whichever comes first
+// Elsewhere the stack limits are unknown, nothing is painted and measure() returns 0
+// Usage within a small margin below the caller (32 bytes on boards, 256 on hosts) also reads as 0
+// On AVR, heap blocks freed during the operation can look like stack: use static buffers for exact numbers
+// If the operation used the whole painted area, measure() returns its size and isCapped() is true
+class QRCodeStackProbe {
+private:
+  uint8_t *top = NULL;
+  uint8_t *bottom = NULL;
+  bool capped = false;
+
+public:
+  void paint();
+  uint32_t measure();
+  bool isCapped();
+};
+
+// Resets the stats when created and fills the generation totals when destroyed
+// The encoding phases are added to stats.encode by the encoder itself, see QRCODE_ENCODE_STATS
+class QRCodeStatsScope {
+private:
+  QRCodeStats &stats;
+  QRCodeStackProbe stackProbe;
+  uint32_t start;
+
+public:
+  QRCodeStatsScope(QRCodeStats &stats) : stats(stats) {
+    reset(stats);
+    stackProbe.paint();
+    start = micros();
+  }
+
+  static void reset(QRCodeStats &stats) {
+    memset(&stats, 0, sizeof(stats));
+    stats.encode.mask = -1; // no mask chosen yet
+  }
+
+  ~QRCodeStatsScope() {
+    stats.generateMicros = micros() - start;
+    stats.stackBytes = stackProbe.measure();
+    stats.stackCapped = stackProbe.isCapped();
+  }
+};
+
+#define QRCODE_STATS_SCOPE(stats) QRCodeStatsScope statsScope(stats)
+#define QRCODE_STATS_DO(statement) statement
+// The counters the encoder fills for a QRCodeStats, each owner passes its own
+#define QRCODE_ENCODE_STATS(stats) (&(stats).encode)
+
+#else
+
+#define QRCODE_STATS_SCOPE(stats)
+#define QRCODE_STATS_DO(statement)
+#define QRCODE_ENCODE_STATS(stats) NULL
+
+#endif
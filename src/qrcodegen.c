@@ -21,18 +21,66 @@
  *   Software.
  */
 
+// The stats clock on computers (see QRCODE_STATS below) is clock_gettime, which strict C modes
+// like -std=c99 only declare for POSIX. QRCODE_STATS may be defined in qrcodegen.h, which is
+// included too late to decide, so this is set whenever stats could be on. macOS declares it anyway
+#if !defined(ARDUINO) && !defined(_POSIX_C_SOURCE) && !defined(__APPLE__)
+	#define _POSIX_C_SOURCE 199309L
+#endif
+
 #include <assert.h>
 #include <limits.h>
 #include <stdlib.h>
 #include <string.h>
 #include "qrcodegen.h"
 
+// Constant tables are kept in flash memory on boards where const data would otherwise
+// be copied to RAM at startup (e.g. AVR), and must then be read with pgm_read_byte()
+#if defined(__AVR__)
+	#include <avr/pgmspace.h>
+#elif defined(ESP8266)
+	#include <pgmspace.h>
+#endif
+#ifndef PROGMEM
+	#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+	#define pgm_read_byte(addr)  (*(const uint8_t *)(addr))
+#endif
+
 #ifndef QRCODEGEN_TEST
 	#define testable static  // Keep functions private
 #else
 	#define testable  // Expose private functions
 #endif
 
+// Statistics of the encoding phases, compiled only when QRCODE_STATS is defined
+#ifdef QRCODE_STATS
+	#ifdef ARDUINO
+		unsigned long micros(void);
+		#define statsClock()  ((uint32_t)micros())
+	#else
+		#include <time.h>
+		static uint32_t statsClock(void) {
+			struct timespec now;
+			clock_gettime(CLOCK_MONOTONIC, &now);
+			return (uint32_t)now.tv_sec * 1000000UL + (uint32_t)(now.tv_nsec / 1000);
+		}
+	#endif
+	// The counters belong to each encode, stats may be NULL when the caller doesn't want them
+	#define STATS_START(name)  uint32_t name = statsClock()
+	#define STATS_TIME(stats, field, start)  do { if ((stats) != NULL) (stats)->field += statsClock() - (start); } while (0)
+	#define STATS_ADD(stats, field, count)  do { if ((stats) != NULL) (stats)->field += (count); } while (0)
+	#define STATS_COUNT(stats, field)  STATS_ADD(stats, field, 1)
+	#define STATS_SET(stats, field, value)  do { if ((stats) != NULL) (stats)->field = (value); } while (0)
+#else
+	#define STATS_START(name)
+	#define STATS_TIME(stats, field, start)  ((void)(stats))
+	#define STATS_ADD(stats, field, count)  ((void)(stats))
+	#define STATS_COUNT(stats, field)  ((void)(stats))
+	#define STATS_SET(stats, field, value)  ((void)(stats))
+#endif
+
 
 /*---- Forward declarations for private functions ----*/
 
@@ -42,6 +90,7 @@
 //   arguments, and return scalar values; they are "pure" functions.
 // - They don't read mutable global variables or write to any global variables.
 // - They don't perform I/O, read the clock, print to console, etc.
+//   (except for the clock read by the statistics when QRCODE_STATS is defined)
 // - They allocate a small and constant amount of stack memory.
 // - They don't allocate or free any memory on the heap.
 // - They don't recurse or mutually recurse. All the code
@@ -54,7 +103,11 @@
 
 testable void appendBitsToBuffer(unsigned int val, int numBits, uint8_t buffer[], int *bitLen);
 
+#ifdef QRCODEGEN_TEST
 testable void addEccAndInterleave(uint8_t data[], int version, enum qrcodegen_Ecc ecl, uint8_t result[]);
+#endif
+static int addBlockEcc(uint8_t data[], int blockOffset, int block, int version, enum qrcodegen_Ecc ecl,
+	const uint8_t rsdiv[], uint8_t result[]);
 testable int getNumDataCodewords(int version, enum qrcodegen_Ecc ecl);
 testable int getNumRawDataModules(int ver);
 
@@ -69,8 +122,18 @@ static void drawFormatBits(enum qrcodegen_Ecc ecl, enum qrcodegen_Mask mask, uin
 testable int getAlignmentPatternPositions(int version, uint8_t result[7]);
 static void fillRectangle(int left, int top, int width, int height, uint8_t qrcode[]);
 
+static bool encodeSegmentsWithExecutor(const struct qrcodegen_Segment segs[], size_t len, enum qrcodegen_Ecc ecl,
+	int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl, uint8_t tempBuffer[], uint8_t qrcode[],
+	const struct qrcodegen_MaskExecutor *executor, uint8_t maskBuffers[], struct qrcodegen_Stats *stats);
+static enum qrcodegen_Mask chooseMaskInParallel(const uint8_t functionModules[], const uint8_t qrcode[], enum qrcodegen_Ecc ecl,
+	int maxVersion, const struct qrcodegen_MaskExecutor *executor, uint8_t maskBuffers[]);
+static void scoreMask(int index, int worker, void *taskContext);
+
 static void drawCodewords(const uint8_t data[], int dataLen, uint8_t qrcode[]);
 static void applyMask(const uint8_t functionModules[], uint8_t qrcode[], enum qrcodegen_Mask mask);
+static bool getMaskBit(enum qrcodegen_Mask mask, int x, int y);
+static void emitMaskedRow(const uint8_t functionModules[], uint8_t qrcode[], enum qrcodegen_Mask mask, int y,
+	bool keepGrid, qrcodegen_RowSink sink, void *context);
 static long getPenaltyScore(const uint8_t qrcode[]);
 static int finderPenaltyCountPatterns(const int runHistory[7], int qrsize);
 static int finderPenaltyTerminateAndCount(bool currentRunColor, int currentRunLength, int runHistory[7], int qrsize);
@@ -82,6 +145,7 @@ testable void setModuleUnbounded(uint8_t qrcode[], int x, int y, bool isDark);
 static bool getBit(int x, int i);
 
 testable int calcSegmentBitLength(enum qrcodegen_Mode mode, size_t numChars);
+static enum qrcodegen_Mode widenTextMode(enum qrcodegen_Mode mode, uint8_t maxIndex);
 testable int getTotalBits(const struct qrcodegen_Segment segs[], size_t len, int version);
 static int numCharCountBits(enum qrcodegen_Mode mode, int version);
 
@@ -89,15 +153,35 @@ static int numCharCountBits(enum qrcodegen_Mode mode, int version);
 
 /*---- Private tables of constants ----*/
 
-// The set of all legal characters in alphanumeric mode, where each character
-// value maps to the index in the string. For checking text and encoding segments.
-static const char *ALPHANUMERIC_CHARSET = "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:";
+// Maps every byte value to its index in the alphanumeric charset
+// "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZ $%*+-./:", or to NOT_ALPHANUMERIC.
+// The index doubles as a character class: digits are below 10, other alphanumeric
+// characters below 45, so the largest value seen in a text tells its narrowest mode.
+#define NOT_ALPHANUMERIC 255
+static const uint8_t ALPHANUMERIC_INDEX[256] PROGMEM = {
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0x00
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0x10
+	 36, 255, 255, 255,  37,  38, 255, 255, 255, 255,  39,  40, 255,  41,  42,  43,  // 0x20
+	  0,   1,   2,   3,   4,   5,   6,   7,   8,   9,  44, 255, 255, 255, 255, 255,  // 0x30
+	255,  10,  11,  12,  13,  14,  15,  16,  17,  18,  19,  20,  21,  22,  23,  24,  // 0x40
+	 25,  26,  27,  28,  29,  30,  31,  32,  33,  34,  35, 255, 255, 255, 255, 255,  // 0x50
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0x60
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0x70
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0x80
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0x90
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0xA0
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0xB0
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0xC0
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0xD0
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0xE0
+	255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255, 255,  // 0xF0
+};
 
 // Sentinel value for use in only some functions.
 #define LENGTH_OVERFLOW -1
 
 // For generating error correction codes.
-testable const int8_t ECC_CODEWORDS_PER_BLOCK[4][41] = {
+testable const int8_t ECC_CODEWORDS_PER_BLOCK[4][41] PROGMEM = {
 	// Version: (note that index 0 is for padding, and is set to an illegal value)
 	//0,  1,  2,  3,  4,  5,  6,  7,  8,  9, 10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40    Error correction level
 	{-1,  7, 10, 15, 20, 26, 18, 20, 24, 30, 18, 20, 24, 26, 30, 22, 24, 28, 30, 28, 28, 28, 28, 30, 30, 26, 28, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30, 30},  // Low
@@ -109,7 +193,7 @@ testable const int8_t ECC_CODEWORDS_PER_BLOCK[4][41] = {
 #define qrcodegen_REED_SOLOMON_DEGREE_MAX 30  // Based on the table above
 
 // For generating error correction codes.
-testable const int8_t NUM_ERROR_CORRECTION_BLOCKS[4][41] = {
+testable const int8_t NUM_ERROR_CORRECTION_BLOCKS[4][41] PROGMEM = {
 	// Version: (note that index 0 is for padding, and is set to an illegal value)
 	//0, 1, 2, 3, 4, 5, 6, 7, 8, 9,10, 11, 12, 13, 14, 15, 16, 17, 18, 19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34, 35, 36, 37, 38, 39, 40    Error correction level
 	{-1, 1, 1, 1, 1, 1, 2, 2, 2, 2, 4,  4,  4,  4,  4,  6,  6,  6,  6,  7,  8,  8,  9,  9, 10, 12, 12, 12, 13, 14, 15, 16, 17, 18, 19, 19, 20, 21, 22, 24, 25},  // Low
@@ -118,6 +202,26 @@ testable const int8_t NUM_ERROR_CORRECTION_BLOCKS[4][41] = {
 	{-1, 1, 1, 2, 4, 4, 4, 5, 6, 8, 8, 11, 11, 16, 16, 18, 16, 19, 21, 25, 25, 25, 34, 30, 32, 35, 37, 40, 42, 45, 48, 51, 54, 57, 60, 63, 66, 70, 74, 77, 81},  // High
 };
 
+// Bit widths of the character count field, indexed by mode (numeric, alphanumeric,
+// byte, kanji) and by version range (1 to 9, 10 to 26, 27 to 40).
+static const uint8_t CHAR_COUNT_BITS[4][3] PROGMEM = {
+	{10, 12, 14},  // Numeric
+	{ 9, 11, 13},  // Alphanumeric
+	{ 8, 16, 16},  // Byte
+	{ 8, 10, 12},  // Kanji
+};
+
+// Accessors for the tables above, which may live in flash memory.
+#define getAlphanumericIndex(c)  pgm_read_byte(&ALPHANUMERIC_INDEX[(uint8_t)(c)])
+#define getEccCodewordsPerBlock(ecl, version)  ((int8_t)pgm_read_byte(&ECC_CODEWORDS_PER_BLOCK[(int)(ecl)][(version)]))
+#define getNumErrorCorrectionBlocks(ecl, version)  ((int8_t)pgm_read_byte(&NUM_ERROR_CORRECTION_BLOCKS[(int)(ecl)][(version)]))
+
+// The number of data bits appended per step while building the bit string of a resumable encode.
+#define SEGMENT_BITS_PER_STEP 512
+
+// The number of rows passed to a row sink per step of the final mask.
+#define ROWS_PER_STEP 16
+
 // For automatic mask pattern selection.
 static const int PENALTY_N1 =  3;
 static const int PENALTY_N2 =  3;
@@ -132,32 +236,25 @@ static const int PENALTY_N4 = 10;
 bool qrcodegen_encodeText(const char *text, uint8_t tempBuffer[], uint8_t qrcode[],
 		enum qrcodegen_Ecc ecl, int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl) {
 	
-	size_t textLen = strlen(text);
+	struct qrcodegen_TextInfo info = qrcodegen_analyzeText(text);
+	return qrcodegen_encodeAnalyzedText(text, &info, tempBuffer, qrcode, ecl, minVersion, maxVersion, mask, boostEcl);
+}
+
+
+// Public function - see documentation comment in header file.
+bool qrcodegen_encodeAnalyzedText(const char *text, const struct qrcodegen_TextInfo *info, uint8_t tempBuffer[],
+		uint8_t qrcode[], enum qrcodegen_Ecc ecl, int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl) {
+	
+	assert(info != NULL);
+	size_t textLen = info->length;
 	if (textLen == 0)
 		return qrcodegen_encodeSegmentsAdvanced(NULL, 0, ecl, minVersion, maxVersion, mask, boostEcl, tempBuffer, qrcode);
 	size_t bufLen = (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion);
 	
-	struct qrcodegen_Segment seg;
-	if (qrcodegen_isNumeric(text)) {
-		if (qrcodegen_calcSegmentBufferSize(qrcodegen_Mode_NUMERIC, textLen) > bufLen)
-			goto fail;
-		seg = qrcodegen_makeNumeric(text, tempBuffer);
-	} else if (qrcodegen_isAlphanumeric(text)) {
-		if (qrcodegen_calcSegmentBufferSize(qrcodegen_Mode_ALPHANUMERIC, textLen) > bufLen)
-			goto fail;
-		seg = qrcodegen_makeAlphanumeric(text, tempBuffer);
-	} else {
-		if (textLen > bufLen)
-			goto fail;
-		for (size_t i = 0; i < textLen; i++)
-			tempBuffer[i] = (uint8_t)text[i];
-		seg.mode = qrcodegen_Mode_BYTE;
-		seg.bitLength = calcSegmentBitLength(seg.mode, textLen);
-		if (seg.bitLength == LENGTH_OVERFLOW)
-			goto fail;
-		seg.numChars = (int)textLen;
-		seg.data = tempBuffer;
-	}
+	if (qrcodegen_calcSegmentBufferSize(info->mode, textLen) > bufLen)
+		goto fail;
+	struct qrcodegen_Segment seg = qrcodegen_beginSegment(info->mode, tempBuffer);
+	qrcodegen_appendToSegment(&seg, text, textLen);
 	return qrcodegen_encodeSegmentsAdvanced(&seg, 1, ecl, minVersion, maxVersion, mask, boostEcl, tempBuffer, qrcode);
 	
 fail:
@@ -206,6 +303,51 @@ bool qrcodegen_encodeSegments(const struct qrcodegen_Segment segs[], size_t len,
 // Public function - see documentation comment in header file.
 bool qrcodegen_encodeSegmentsAdvanced(const struct qrcodegen_Segment segs[], size_t len, enum qrcodegen_Ecc ecl,
 		int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl, uint8_t tempBuffer[], uint8_t qrcode[]) {
+	return encodeSegmentsWithExecutor(segs, len, ecl, minVersion, maxVersion, mask, boostEcl, tempBuffer, qrcode, NULL, NULL, NULL);
+}
+
+
+// Public function - see documentation comment in header file.
+bool qrcodegen_encodeSegmentsParallel(const struct qrcodegen_Segment segs[], size_t len, enum qrcodegen_Ecc ecl,
+		int minVersion, int maxVersion, bool boostEcl, uint8_t tempBuffer[], uint8_t qrcode[],
+		const struct qrcodegen_MaskExecutor *executor, uint8_t maskBuffers[], struct qrcodegen_Stats *stats) {
+	assert(executor != NULL && executor->parallelFor != NULL && executor->workerCount >= 1 && maskBuffers != NULL);
+	return encodeSegmentsWithExecutor(segs, len, ecl, minVersion, maxVersion, qrcodegen_Mask_AUTO, boostEcl,
+		tempBuffer, qrcode, executor, maskBuffers, stats);
+}
+
+
+// Implements both public functions above. The executor (and maskBuffers) is NULL to evaluate masks serially.
+static bool encodeSegmentsWithExecutor(const struct qrcodegen_Segment segs[], size_t len, enum qrcodegen_Ecc ecl,
+		int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl, uint8_t tempBuffer[], uint8_t qrcode[],
+		const struct qrcodegen_MaskExecutor *executor, uint8_t maskBuffers[], struct qrcodegen_Stats *stats) {
+	struct qrcodegen_Encoder enc;
+	if (!qrcodegen_beginEncode(&enc, segs, len, ecl, minVersion, maxVersion, mask, boostEcl, tempBuffer, qrcode, stats))
+		return false;
+	
+	enum qrcodegen_EncodePhase phase = enc.phase;
+	while (phase != qrcodegen_EncodePhase_DONE) {
+		if (phase == qrcodegen_EncodePhase_MASK_TRIAL && executor != NULL) {
+			// Replaces the serial mask trials
+			STATS_START(start);
+			enc.mask = chooseMaskInParallel(tempBuffer, qrcode, enc.ecl, maxVersion, executor, maskBuffers);
+			STATS_TIME(stats, maskMicros, start);
+			// Every trial masks its own copy of the grid once, nothing needs undoing
+			STATS_ADD(stats, maskApplications, 8);
+			STATS_ADD(stats, penaltyScores, 8);
+			enc.phase = qrcodegen_EncodePhase_FINAL_MASK;
+		}
+		phase = qrcodegen_encodeStep(&enc);
+	}
+	return true;
+}
+
+
+// Public function - see documentation comment in header file.
+bool qrcodegen_beginEncode(struct qrcodegen_Encoder *enc, const struct qrcodegen_Segment segs[], size_t len,
+		enum qrcodegen_Ecc ecl, int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl,
+		uint8_t tempBuffer[], uint8_t qrcode[], struct qrcodegen_Stats *stats) {
+	assert(enc != NULL);
 	assert(segs != NULL || len == 0);
 	assert(qrcodegen_VERSION_MIN <= minVersion && minVersion <= maxVersion && maxVersion <= qrcodegen_VERSION_MAX);
 	assert(0 <= (int)ecl && (int)ecl <= 3 && -1 <= (int)mask && (int)mask <= 7);
@@ -230,60 +372,227 @@ bool qrcodegen_encodeSegmentsAdvanced(const struct qrcodegen_Segment segs[], siz
 			ecl = (enum qrcodegen_Ecc)i;
 	}
 	
-	// Concatenate all segments to create the data bit string
 	memset(qrcode, 0, (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION(version) * sizeof(qrcode[0]));
-	int bitLen = 0;
-	for (size_t i = 0; i < len; i++) {
-		const struct qrcodegen_Segment *seg = &segs[i];
-		appendBitsToBuffer((unsigned int)seg->mode, 4, qrcode, &bitLen);
-		appendBitsToBuffer((unsigned int)seg->numChars, numCharCountBits(seg->mode, version), qrcode, &bitLen);
-		for (int j = 0; j < seg->bitLength; j++) {
-			int bit = (seg->data[j >> 3] >> (7 - (j & 7))) & 1;
-			appendBitsToBuffer((unsigned int)bit, 1, qrcode, &bitLen);
-		}
-	}
-	assert(bitLen == dataUsedBits);
-	
-	// Add terminator and pad up to a byte if applicable
-	int dataCapacityBits = getNumDataCodewords(version, ecl) * 8;
-	assert(bitLen <= dataCapacityBits);
-	int terminatorBits = dataCapacityBits - bitLen;
-	if (terminatorBits > 4)
-		terminatorBits = 4;
-	appendBitsToBuffer(0, terminatorBits, qrcode, &bitLen);
-	appendBitsToBuffer(0, (8 - bitLen % 8) % 8, qrcode, &bitLen);
-	assert(bitLen % 8 == 0);
-	
-	// Pad with alternating bytes until data capacity is reached
-	for (uint8_t padByte = 0xEC; bitLen < dataCapacityBits; padByte ^= 0xEC ^ 0x11)
-		appendBitsToBuffer(padByte, 8, qrcode, &bitLen);
-	
-	// Compute ECC, draw modules
-	addEccAndInterleave(qrcode, version, ecl, tempBuffer);
-	initializeFunctionModules(version, qrcode);
-	drawCodewords(tempBuffer, getNumRawDataModules(version) / 8, qrcode);
-	drawLightFunctionModules(qrcode, version);
-	initializeFunctionModules(version, tempBuffer);
+	enc->segs = segs;
+	enc->len = len;
+	enc->tempBuffer = tempBuffer;
+	enc->qrcode = qrcode;
+	enc->ecl = ecl;
+	enc->mask = mask;
+	enc->phase = qrcodegen_EncodePhase_SEGMENTS;
+	enc->version = version;
+	enc->dataUsedBits = dataUsedBits;
+	enc->bitLen = 0;
+	enc->segIndex = 0;
+	enc->segBit = -1;
+	enc->counter = 0;
+	enc->dataOffset = 0;
+	enc->minPenalty = LONG_MAX;
+	enc->rowSink = NULL;
+	enc->rowSinkContext = NULL;
+	enc->keepGrid = true;
+	enc->nextRow = 0;
+	enc->stats = stats;
+	return true;
+}
+
+
+// Public function - see documentation comment in header file.
+enum qrcodegen_EncodePhase qrcodegen_encodeStep(struct qrcodegen_Encoder *enc) {
+	assert(enc != NULL);
+	uint8_t *qrcode = enc->qrcode;
+	uint8_t *tempBuffer = enc->tempBuffer;
+	int version = enc->version;
+	STATS_START(start);
 	
-	// Do masking
-	if (mask == qrcodegen_Mask_AUTO) {  // Automatically choose best mask
-		long minPenalty = LONG_MAX;
-		for (int i = 0; i < 8; i++) {
-			enum qrcodegen_Mask msk = (enum qrcodegen_Mask)i;
+	switch (enc->phase) {
+		case qrcodegen_EncodePhase_SEGMENTS: {
+			// Concatenate the segments into the data bit string, a bounded number of bits per step
+			int budget = SEGMENT_BITS_PER_STEP;
+			while (budget > 0 && enc->segIndex < (int)enc->len) {
+				const struct qrcodegen_Segment *seg = &enc->segs[enc->segIndex];
+				if (enc->segBit < 0) {
+					appendBitsToBuffer((unsigned int)seg->mode, 4, qrcode, &enc->bitLen);
+					appendBitsToBuffer((unsigned int)seg->numChars, numCharCountBits(seg->mode, version), qrcode, &enc->bitLen);
+					enc->segBit = 0;
+				}
+				for (; enc->segBit < seg->bitLength && budget > 0; enc->segBit++, budget--) {
+					int j = enc->segBit;
+					int bit = (seg->data[j >> 3] >> (7 - (j & 7))) & 1;
+					appendBitsToBuffer((unsigned int)bit, 1, qrcode, &enc->bitLen);
+				}
+				if (enc->segBit == seg->bitLength) {
+					enc->segIndex++;
+					enc->segBit = -1;
+				}
+			}
+			if (enc->segIndex < (int)enc->len) {
+				STATS_TIME(enc->stats, segmentMicros, start);
+				break;
+			}
+			assert(enc->bitLen == enc->dataUsedBits);
+			
+			// Add terminator and pad up to a byte if applicable
+			int dataCapacityBits = getNumDataCodewords(version, enc->ecl) * 8;
+			assert(enc->bitLen <= dataCapacityBits);
+			int terminatorBits = dataCapacityBits - enc->bitLen;
+			if (terminatorBits > 4)
+				terminatorBits = 4;
+			appendBitsToBuffer(0, terminatorBits, qrcode, &enc->bitLen);
+			appendBitsToBuffer(0, (8 - enc->bitLen % 8) % 8, qrcode, &enc->bitLen);
+			assert(enc->bitLen % 8 == 0);
+			
+			// Pad with alternating bytes until data capacity is reached
+			for (uint8_t padByte = 0xEC; enc->bitLen < dataCapacityBits; padByte ^= 0xEC ^ 0x11)
+				appendBitsToBuffer(padByte, 8, qrcode, &enc->bitLen);
+			
+			reedSolomonComputeDivisor(getEccCodewordsPerBlock(enc->ecl, version), enc->rsdiv);
+			enc->phase = qrcodegen_EncodePhase_ECC;
+			STATS_TIME(enc->stats, segmentMicros, start);
+			STATS_SET(enc->stats, version, version);
+			break;
+		}
+		
+		case qrcodegen_EncodePhase_ECC:
+			// One block per step
+			enc->dataOffset += addBlockEcc(qrcode, enc->dataOffset, enc->counter, version, enc->ecl, enc->rsdiv, tempBuffer);
+			enc->counter++;
+			if (enc->counter == getNumErrorCorrectionBlocks(enc->ecl, version)) {
+				enc->counter = 0;
+				enc->phase = qrcodegen_EncodePhase_PLACEMENT;
+			}
+			STATS_TIME(enc->stats, eccMicros, start);
+			STATS_COUNT(enc->stats, eccBlocks);
+			break;
+		
+		case qrcodegen_EncodePhase_PLACEMENT:
+			if (enc->counter == 0) {
+				initializeFunctionModules(version, qrcode);
+				drawCodewords(tempBuffer, getNumRawDataModules(version) / 8, qrcode);
+				enc->counter = 1;
+			} else {
+				drawLightFunctionModules(qrcode, version);
+				initializeFunctionModules(version, tempBuffer);
+				enc->counter = 0;
+				enc->phase = enc->mask == qrcodegen_Mask_AUTO ? qrcodegen_EncodePhase_MASK_TRIAL : qrcodegen_EncodePhase_FINAL_MASK;
+			}
+			STATS_TIME(enc->stats, placementMicros, start);
+			break;
+		
+		case qrcodegen_EncodePhase_MASK_TRIAL: {
+			// Score one mask per step
+			enum qrcodegen_Mask msk = (enum qrcodegen_Mask)enc->counter;
 			applyMask(tempBuffer, qrcode, msk);
-			drawFormatBits(ecl, msk, qrcode);
+			drawFormatBits(enc->ecl, msk, qrcode);
+			STATS_TIME(enc->stats, maskMicros, start);
+			STATS_START(penaltyStart);
 			long penalty = getPenaltyScore(qrcode);
-			if (penalty < minPenalty) {
-				mask = msk;
-				minPenalty = penalty;
+			STATS_TIME(enc->stats, penaltyMicros, penaltyStart);
+			STATS_COUNT(enc->stats, penaltyScores);
+			if (penalty < enc->minPenalty) {
+				enc->mask = msk;
+				enc->minPenalty = penalty;
 			}
+			STATS_START(undoStart);
 			applyMask(tempBuffer, qrcode, msk);  // Undoes the mask due to XOR
+			STATS_TIME(enc->stats, maskMicros, undoStart);
+			STATS_ADD(enc->stats, maskApplications, 2);  // The mask was applied, then undone
+			enc->counter++;
+			if (enc->counter == 8)
+				enc->phase = qrcodegen_EncodePhase_FINAL_MASK;
+			break;
 		}
+		
+		case qrcodegen_EncodePhase_FINAL_MASK:
+			assert(0 <= (int)enc->mask && (int)enc->mask <= 7);
+			if (enc->rowSink == NULL) {
+				applyMask(tempBuffer, qrcode, enc->mask);  // Apply the final choice of mask
+				drawFormatBits(enc->ecl, enc->mask, qrcode);  // Overwrite old format bits
+				enc->phase = qrcodegen_EncodePhase_DONE;
+			} else {
+				// Format bits are function modules, the mask never touches them, so they can go first
+				if (enc->nextRow == 0)
+					drawFormatBits(enc->ecl, enc->mask, qrcode);
+				int qrsize = qrcodegen_getSize(qrcode);
+				int endRow = enc->nextRow + ROWS_PER_STEP < qrsize ? enc->nextRow + ROWS_PER_STEP : qrsize;
+				for (; enc->nextRow < endRow; enc->nextRow++) {
+					emitMaskedRow(tempBuffer, qrcode, enc->mask, enc->nextRow, enc->keepGrid,
+						enc->rowSink, enc->rowSinkContext);
+				}
+				if (enc->nextRow == qrsize)
+					enc->phase = qrcodegen_EncodePhase_DONE;
+			}
+			STATS_TIME(enc->stats, maskMicros, start);
+			if (enc->phase == qrcodegen_EncodePhase_DONE) {
+				STATS_COUNT(enc->stats, maskApplications);
+				STATS_SET(enc->stats, mask, (int8_t)enc->mask);
+			}
+			break;
+		
+		case qrcodegen_EncodePhase_DONE:
+			break;
 	}
-	assert(0 <= (int)mask && (int)mask <= 7);
-	applyMask(tempBuffer, qrcode, mask);  // Apply the final choice of mask
-	drawFormatBits(ecl, mask, qrcode);  // Overwrite old format bits
-	return true;
+	return enc->phase;
+}
+
+
+// Public function - see documentation comment in header file.
+void qrcodegen_setRowSink(struct qrcodegen_Encoder *enc, qrcodegen_RowSink sink, void *context, bool keepGrid) {
+	assert(enc != NULL && enc->phase < qrcodegen_EncodePhase_FINAL_MASK);
+	enc->rowSink = sink;
+	enc->rowSinkContext = context;
+	enc->keepGrid = keepGrid || sink == NULL;
+}
+
+
+// Public function - see documentation comment in header file.
+int qrcodegen_getEncodeProgress(const struct qrcodegen_Encoder *enc) {
+	assert(enc != NULL);
+	// Rough share of the total work of each phase, with automatic masking
+	switch (enc->phase) {
+		case qrcodegen_EncodePhase_SEGMENTS:
+			return enc->dataUsedBits > 0 ? (int)(5L * enc->bitLen / enc->dataUsedBits) : 0;
+		case qrcodegen_EncodePhase_ECC:
+			return 5 + 25 * enc->counter / getNumErrorCorrectionBlocks(enc->ecl, enc->version);
+		case qrcodegen_EncodePhase_PLACEMENT:
+			return 30 + 5 * enc->counter;
+		case qrcodegen_EncodePhase_MASK_TRIAL:
+			return 40 + 55 * enc->counter / 8;
+		case qrcodegen_EncodePhase_FINAL_MASK:
+			return 95 + 4 * enc->nextRow / qrcodegen_getSize(enc->qrcode);
+		default:
+			return 100;
+	}
+}
+
+
+// Public function - see documentation comment in header file.
+int qrcodegen_getMinVersion(enum qrcodegen_Mode mode, size_t numChars,
+		enum qrcodegen_Ecc ecl, int minVersion, int maxVersion, struct qrcodegen_Stats *stats) {
+	assert(qrcodegen_VERSION_MIN <= minVersion && minVersion <= maxVersion && maxVersion <= qrcodegen_VERSION_MAX);
+	STATS_START(start);
+	int dataBits = calcSegmentBitLength(mode, numChars);
+	if (dataBits == LENGTH_OVERFLOW) {
+		STATS_TIME(stats, versionMicros, start);
+		STATS_COUNT(stats, versionSearches);
+		return 0;
+	}
+	
+	// Both the capacity and the needed bits grow with the version, so the
+	// versions that fit form a suffix of the range; binary search for its start
+	int low = minVersion, high = maxVersion + 1;
+	while (low < high) {
+		int version = (low + high) / 2;
+		int ccbits = numCharCountBits(mode, version);
+		long usedBits = 4L + ccbits + dataBits;
+		if (numChars < (1UL << ccbits) && usedBits <= getNumDataCodewords(version, ecl) * 8L)
+			high = version;
+		else
+			low = version + 1;
+	}
+	STATS_TIME(stats, versionMicros, start);
+	STATS_COUNT(stats, versionSearches);
+	return low <= maxVersion ? low : 0;
 }
 
 
@@ -294,34 +603,47 @@ bool qrcodegen_encodeSegmentsAdvanced(const struct qrcodegen_Segment segs[], siz
 // bytes from the blocks and stores them in the result array. data[0 : dataLen] contains
 // the input data. data[dataLen : rawCodewords] is used as a temporary work area and will
 // be clobbered by this function. The final answer is stored in result[0 : rawCodewords].
+// The encoder does this one block per step instead, so only the tests use it.
+#ifdef QRCODEGEN_TEST
 testable void addEccAndInterleave(uint8_t data[], int version, enum qrcodegen_Ecc ecl, uint8_t result[]) {
-	// Calculate parameter numbers
 	assert(0 <= (int)ecl && (int)ecl < 4 && qrcodegen_VERSION_MIN <= version && version <= qrcodegen_VERSION_MAX);
-	int numBlocks = NUM_ERROR_CORRECTION_BLOCKS[(int)ecl][version];
-	int blockEccLen = ECC_CODEWORDS_PER_BLOCK  [(int)ecl][version];
+	uint8_t rsdiv[qrcodegen_REED_SOLOMON_DEGREE_MAX];
+	reedSolomonComputeDivisor(getEccCodewordsPerBlock(ecl, version), rsdiv);
+	int numBlocks = getNumErrorCorrectionBlocks(ecl, version);
+	for (int i = 0, offset = 0; i < numBlocks; i++)
+		offset += addBlockEcc(data, offset, i, version, ecl, rsdiv, result);
+}
+#endif
+
+
+// Computes the ECC of the given block, whose data starts at data[blockOffset], and interleaves the
+// block's data and ECC bytes into the result array. Returns the number of data bytes in the block.
+// rsdiv must be the generator polynomial for the version and ECC level. Same array requirements
+// as addEccAndInterleave(). The step encoder calls this for every block in order.
+static int addBlockEcc(uint8_t data[], int blockOffset, int block, int version, enum qrcodegen_Ecc ecl,
+		const uint8_t rsdiv[], uint8_t result[]) {
+	// Calculate parameter numbers
+	int numBlocks = getNumErrorCorrectionBlocks(ecl, version);
+	int blockEccLen = getEccCodewordsPerBlock  (ecl, version);
 	int rawCodewords = getNumRawDataModules(version) / 8;
 	int dataLen = getNumDataCodewords(version, ecl);
 	int numShortBlocks = numBlocks - rawCodewords % numBlocks;
 	int shortBlockDataLen = rawCodewords / numBlocks - blockEccLen;
+	assert(0 <= block && block < numBlocks);
 	
-	// Split data into blocks, calculate ECC, and interleave
-	// (not concatenate) the bytes into a single sequence
-	uint8_t rsdiv[qrcodegen_REED_SOLOMON_DEGREE_MAX];
-	reedSolomonComputeDivisor(blockEccLen, rsdiv);
-	const uint8_t *dat = data;
-	for (int i = 0; i < numBlocks; i++) {
-		int datLen = shortBlockDataLen + (i < numShortBlocks ? 0 : 1);
-		uint8_t *ecc = &data[dataLen];  // Temporary storage
-		reedSolomonComputeRemainder(dat, datLen, rsdiv, blockEccLen, ecc);
-		for (int j = 0, k = i; j < datLen; j++, k += numBlocks) {  // Copy data
-			if (j == shortBlockDataLen)
-				k -= numShortBlocks;
-			result[k] = dat[j];
-		}
-		for (int j = 0, k = dataLen + i; j < blockEccLen; j++, k += numBlocks)  // Copy ECC
-			result[k] = ecc[j];
-		dat += datLen;
+	// Calculate the block's ECC, and interleave (not concatenate) its bytes with the other blocks
+	const uint8_t *dat = &data[blockOffset];
+	int datLen = shortBlockDataLen + (block < numShortBlocks ? 0 : 1);
+	uint8_t *ecc = &data[dataLen];  // Temporary storage
+	reedSolomonComputeRemainder(dat, datLen, rsdiv, blockEccLen, ecc);
+	for (int j = 0, k = block; j < datLen; j++, k += numBlocks) {  // Copy data
+		if (j == shortBlockDataLen)
+			k -= numShortBlocks;
+		result[k] = dat[j];
 	}
+	for (int j = 0, k = dataLen + block; j < blockEccLen; j++, k += numBlocks)  // Copy ECC
+		result[k] = ecc[j];
+	return datLen;
 }
 
 
@@ -331,8 +653,8 @@ testable int getNumDataCodewords(int version, enum qrcodegen_Ecc ecl) {
 	int v = version, e = (int)ecl;
 	assert(0 <= e && e < 4);
 	return getNumRawDataModules(v) / 8
-		- ECC_CODEWORDS_PER_BLOCK    [e][v]
-		* NUM_ERROR_CORRECTION_BLOCKS[e][v];
+		- getEccCodewordsPerBlock    (e, v)
+		* getNumErrorCorrectionBlocks(e, v);
 }
 
 
@@ -519,8 +841,8 @@ static void drawLightFunctionModules(uint8_t qrcode[], int version) {
 static void drawFormatBits(enum qrcodegen_Ecc ecl, enum qrcodegen_Mask mask, uint8_t qrcode[]) {
 	// Calculate error correction code and pack bits
 	assert(0 <= (int)mask && (int)mask <= 7);
-	static const int table[] = {1, 0, 3, 2};
-	int data = table[(int)ecl] << 3 | (int)mask;  // errCorrLvl is uint2, mask is uint3
+	// The format bits encode Low, Medium, Quartile, High as 1, 0, 3, 2, which is the enum value XOR 1
+	int data = ((int)ecl ^ 1) << 3 | (int)mask;  // errCorrLvl is uint2, mask is uint3
 	int rem = data;
 	for (int i = 0; i < 10; i++)
 		rem = (rem << 1) ^ ((rem >> 9) * 0x537);
@@ -574,6 +896,51 @@ static void fillRectangle(int left, int top, int width, int height, uint8_t qrco
 
 /*---- Drawing data modules and masking ----*/
 
+// Shared by the mask trials of chooseMaskInParallel().
+struct MaskTrials {
+	const uint8_t *functionModules;
+	const uint8_t *qrcode;  // Unmasked grid, copied by every trial
+	enum qrcodegen_Ecc ecl;
+	uint8_t *maskBuffers;
+	size_t bufferLen;  // Stride between grid copies in maskBuffers
+	long penalties[8];
+};
+
+
+// Scores every mask on the executor's workers and returns the best one.
+// Ties go to the lowest mask number, like the serial loop.
+static enum qrcodegen_Mask chooseMaskInParallel(const uint8_t functionModules[], const uint8_t qrcode[], enum qrcodegen_Ecc ecl,
+		int maxVersion, const struct qrcodegen_MaskExecutor *executor, uint8_t maskBuffers[]) {
+	struct MaskTrials trials;
+	trials.functionModules = functionModules;
+	trials.qrcode = qrcode;
+	trials.ecl = ecl;
+	trials.maskBuffers = maskBuffers;
+	trials.bufferLen = (size_t)qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion);
+	executor->parallelFor(8, scoreMask, &trials, executor->executorContext);
+	
+	int best = 0;
+	for (int i = 1; i < 8; i++) {
+		if (trials.penalties[i] < trials.penalties[best])
+			best = i;
+	}
+	return (enum qrcodegen_Mask)best;
+}
+
+
+// A task of chooseMaskInParallel(). Masks a copy of the grid owned by the worker and scores it.
+static void scoreMask(int index, int worker, void *taskContext) {
+	struct MaskTrials *trials = (struct MaskTrials *)taskContext;
+	assert(0 <= index && index < 8 && worker >= 0);
+	uint8_t *grid = &trials->maskBuffers[(size_t)worker * trials->bufferLen];
+	int qrsize = qrcodegen_getSize(trials->qrcode);
+	memcpy(grid, trials->qrcode, (size_t)((qrsize * qrsize + 7) / 8 + 1) * sizeof(grid[0]));
+	applyMask(trials->functionModules, grid, (enum qrcodegen_Mask)index);
+	drawFormatBits(trials->ecl, (enum qrcodegen_Mask)index, grid);
+	trials->penalties[index] = getPenaltyScore(grid);
+}
+
+
 // Draws the raw codewords (including data and ECC) onto the given QR Code. This requires the initial state of
 // the QR Code to be dark at function modules and light at codeword modules (including unused remainder bits).
 static void drawCodewords(const uint8_t data[], int dataLen, uint8_t qrcode[]) {
@@ -614,18 +981,7 @@ static void applyMask(const uint8_t functionModules[], uint8_t qrcode[], enum qr
 		for (int x = 0; x < qrsize; x++) {
 			if (getModuleBounded(functionModules, x, y))
 				continue;
-			bool invert;
-			switch ((int)mask) {
-				case 0:  invert = (x + y) % 2 == 0;                    break;
-				case 1:  invert = y % 2 == 0;                          break;
-				case 2:  invert = x % 3 == 0;                          break;
-				case 3:  invert = (x + y) % 3 == 0;                    break;
-				case 4:  invert = (x / 3 + y / 2) % 2 == 0;            break;
-				case 5:  invert = x * y % 2 + x * y % 3 == 0;          break;
-				case 6:  invert = (x * y % 2 + x * y % 3) % 2 == 0;    break;
-				case 7:  invert = ((x + y) % 2 + x * y % 3) % 2 == 0;  break;
-				default:  assert(false);  return;
-			}
+			bool invert = getMaskBit(mask, x, y);
 			bool val = getModuleBounded(qrcode, x, y);
 			setModuleBounded(qrcode, x, y, val ^ invert);
 		}
@@ -633,6 +989,43 @@ static void applyMask(const uint8_t functionModules[], uint8_t qrcode[], enum qr
 }
 
 
+// Returns whether the given mask pattern inverts the module at (x, y).
+static bool getMaskBit(enum qrcodegen_Mask mask, int x, int y) {
+	switch ((int)mask) {
+		case 0:  return (x + y) % 2 == 0;
+		case 1:  return y % 2 == 0;
+		case 2:  return x % 3 == 0;
+		case 3:  return (x + y) % 3 == 0;
+		case 4:  return (x / 3 + y / 2) % 2 == 0;
+		case 5:  return x * y % 2 + x * y % 3 == 0;
+		case 6:  return (x * y % 2 + x * y % 3) % 2 == 0;
+		case 7:  return ((x + y) % 2 + x * y % 3) % 2 == 0;
+		default:  assert(false);  return false;
+	}
+}
+
+
+// Masks row y of the given unmasked QR Code and passes it to the sink, packed most significant bit
+// first. The masked modules are written back to qrcode only if keepGrid is true.
+static void emitMaskedRow(const uint8_t functionModules[], uint8_t qrcode[], enum qrcodegen_Mask mask, int y,
+		bool keepGrid, qrcodegen_RowSink sink, void *context) {
+	uint8_t row[(qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8];
+	int qrsize = qrcodegen_getSize(qrcode);
+	memset(row, 0, (size_t)(qrsize + 7) / 8);
+	for (int x = 0; x < qrsize; x++) {
+		bool dark = getModuleBounded(qrcode, x, y);
+		if (!getModuleBounded(functionModules, x, y) && getMaskBit(mask, x, y)) {
+			dark = !dark;
+			if (keepGrid)
+				setModuleBounded(qrcode, x, y, dark);
+		}
+		if (dark)
+			row[x >> 3] |= (uint8_t)(0x80 >> (x & 7));
+	}
+	sink(y, row, qrsize, context);
+}
+
+
 // Calculates and returns the penalty score based on state of the given QR Code's current modules.
 // This is used by the automatic mask choice algorithm to find the mask pattern that yields the lowest score.
 static long getPenaltyScore(const uint8_t qrcode[]) {
@@ -812,7 +1205,7 @@ static bool getBit(int x, int i) {
 bool qrcodegen_isNumeric(const char *text) {
 	assert(text != NULL);
 	for (; *text != '\0'; text++) {
-		if (*text < '0' || *text > '9')
+		if (getAlphanumericIndex(*text) >= 10)
 			return false;
 	}
 	return true;
@@ -823,13 +1216,55 @@ bool qrcodegen_isNumeric(const char *text) {
 bool qrcodegen_isAlphanumeric(const char *text) {
 	assert(text != NULL);
 	for (; *text != '\0'; text++) {
-		if (strchr(ALPHANUMERIC_CHARSET, *text) == NULL)
+		if (getAlphanumericIndex(*text) == NOT_ALPHANUMERIC)
 			return false;
 	}
 	return true;
 }
 
 
+// Public function - see documentation comment in header file.
+struct qrcodegen_TextInfo qrcodegen_analyzeText(const char *text) {
+	assert(text != NULL);
+	const char *start = text;
+	uint8_t maxIndex = 0;
+	for (; *text != '\0'; text++) {
+		uint8_t index = getAlphanumericIndex(*text);
+		if (index > maxIndex)
+			maxIndex = index;
+	}
+	struct qrcodegen_TextInfo result;
+	result.length = (size_t)(text - start);
+	result.mode = widenTextMode(qrcodegen_Mode_NUMERIC, maxIndex);
+	return result;
+}
+
+
+// Public function - see documentation comment in header file.
+void qrcodegen_extendTextInfo(struct qrcodegen_TextInfo *info, const char *text, size_t len) {
+	assert(info != NULL && (text != NULL || len == 0));
+	uint8_t maxIndex = 0;
+	for (size_t i = 0; i < len; i++) {
+		uint8_t index = getAlphanumericIndex(text[i]);
+		if (index > maxIndex)
+			maxIndex = index;
+	}
+	info->length += len;
+	info->mode = widenTextMode(info->mode, maxIndex);
+}
+
+
+// Returns the most compact mode that can encode both the text described by the given mode
+// and characters whose largest alphanumeric index is maxIndex. A helper for text analysis.
+static enum qrcodegen_Mode widenTextMode(enum qrcodegen_Mode mode, uint8_t maxIndex) {
+	if (mode == qrcodegen_Mode_BYTE || maxIndex == NOT_ALPHANUMERIC)
+		return qrcodegen_Mode_BYTE;
+	if (mode == qrcodegen_Mode_ALPHANUMERIC || maxIndex >= 10)
+		return qrcodegen_Mode_ALPHANUMERIC;
+	return qrcodegen_Mode_NUMERIC;
+}
+
+
 // Public function - see documentation comment in header file.
 size_t qrcodegen_calcSegmentBufferSize(enum qrcodegen_Mode mode, size_t numChars) {
 	int temp = calcSegmentBitLength(mode, numChars);
@@ -892,33 +1327,8 @@ struct qrcodegen_Segment qrcodegen_makeBytes(const uint8_t data[], size_t len, u
 // Public function - see documentation comment in header file.
 struct qrcodegen_Segment qrcodegen_makeNumeric(const char *digits, uint8_t buf[]) {
 	assert(digits != NULL);
-	struct qrcodegen_Segment result;
-	size_t len = strlen(digits);
-	result.mode = qrcodegen_Mode_NUMERIC;
-	int bitLen = calcSegmentBitLength(result.mode, len);
-	assert(bitLen != LENGTH_OVERFLOW);
-	result.numChars = (int)len;
-	if (bitLen > 0)
-		memset(buf, 0, ((size_t)bitLen + 7) / 8 * sizeof(buf[0]));
-	result.bitLength = 0;
-	
-	unsigned int accumData = 0;
-	int accumCount = 0;
-	for (; *digits != '\0'; digits++) {
-		char c = *digits;
-		assert('0' <= c && c <= '9');
-		accumData = accumData * 10 + (unsigned int)(c - '0');
-		accumCount++;
-		if (accumCount == 3) {
-			appendBitsToBuffer(accumData, 10, buf, &result.bitLength);
-			accumData = 0;
-			accumCount = 0;
-		}
-	}
-	if (accumCount > 0)  // 1 or 2 digits remaining
-		appendBitsToBuffer(accumData, accumCount * 3 + 1, buf, &result.bitLength);
-	assert(result.bitLength == bitLen);
-	result.data = buf;
+	struct qrcodegen_Segment result = qrcodegen_beginSegment(qrcodegen_Mode_NUMERIC, buf);
+	qrcodegen_appendToSegment(&result, digits, strlen(digits));
 	return result;
 }
 
@@ -926,34 +1336,74 @@ struct qrcodegen_Segment qrcodegen_makeNumeric(const char *digits, uint8_t buf[]
 // Public function - see documentation comment in header file.
 struct qrcodegen_Segment qrcodegen_makeAlphanumeric(const char *text, uint8_t buf[]) {
 	assert(text != NULL);
+	struct qrcodegen_Segment result = qrcodegen_beginSegment(qrcodegen_Mode_ALPHANUMERIC, buf);
+	qrcodegen_appendToSegment(&result, text, strlen(text));
+	return result;
+}
+
+
+// Public function - see documentation comment in header file.
+struct qrcodegen_Segment qrcodegen_beginSegment(enum qrcodegen_Mode mode, uint8_t buf[]) {
+	assert(mode == qrcodegen_Mode_NUMERIC || mode == qrcodegen_Mode_ALPHANUMERIC || mode == qrcodegen_Mode_BYTE);
 	struct qrcodegen_Segment result;
-	size_t len = strlen(text);
-	result.mode = qrcodegen_Mode_ALPHANUMERIC;
-	int bitLen = calcSegmentBitLength(result.mode, len);
-	assert(bitLen != LENGTH_OVERFLOW);
-	result.numChars = (int)len;
-	if (bitLen > 0)
-		memset(buf, 0, ((size_t)bitLen + 7) / 8 * sizeof(buf[0]));
+	result.mode = mode;
+	result.numChars = 0;
 	result.bitLength = 0;
+	result.data = buf;
+	return result;
+}
+
+
+// Public function - see documentation comment in header file.
+void qrcodegen_appendToSegment(struct qrcodegen_Segment *seg, const char *text, size_t len) {
+	assert(seg != NULL && (text != NULL || len == 0));
+	int bitLen = calcSegmentBitLength(seg->mode, (size_t)seg->numChars + len);
+	assert(bitLen != LENGTH_OVERFLOW);
+	size_t usedBytes = ((size_t)seg->bitLength + 7) / 8;
+	size_t neededBytes = ((size_t)bitLen + 7) / 8;
+	if (neededBytes > usedBytes)
+		memset(&seg->data[usedBytes], 0, (neededBytes - usedBytes) * sizeof(seg->data[0]));
 	
 	unsigned int accumData = 0;
 	int accumCount = 0;
-	for (; *text != '\0'; text++) {
-		const char *temp = strchr(ALPHANUMERIC_CHARSET, *text);
-		assert(temp != NULL);
-		accumData = accumData * 45 + (unsigned int)(temp - ALPHANUMERIC_CHARSET);
-		accumCount++;
-		if (accumCount == 2) {
-			appendBitsToBuffer(accumData, 11, buf, &result.bitLength);
-			accumData = 0;
-			accumCount = 0;
+	if (seg->mode == qrcodegen_Mode_NUMERIC) {
+		assert(len == 0 || seg->numChars % 3 == 0);  // Groups of 3 digits can't be split
+		for (size_t i = 0; i < len; i++) {
+			char c = text[i];
+			assert('0' <= c && c <= '9');
+			accumData = accumData * 10 + (unsigned int)(c - '0');
+			accumCount++;
+			if (accumCount == 3) {
+				appendBitsToBuffer(accumData, 10, seg->data, &seg->bitLength);
+				accumData = 0;
+				accumCount = 0;
+			}
+		}
+		if (accumCount > 0)  // 1 or 2 digits remaining
+			appendBitsToBuffer(accumData, accumCount * 3 + 1, seg->data, &seg->bitLength);
+	} else if (seg->mode == qrcodegen_Mode_ALPHANUMERIC) {
+		assert(len == 0 || seg->numChars % 2 == 0);  // Pairs of characters can't be split
+		for (size_t i = 0; i < len; i++) {
+			uint8_t index = getAlphanumericIndex(text[i]);
+			assert(index != NOT_ALPHANUMERIC);
+			accumData = accumData * 45 + index;
+			accumCount++;
+			if (accumCount == 2) {
+				appendBitsToBuffer(accumData, 11, seg->data, &seg->bitLength);
+				accumData = 0;
+				accumCount = 0;
+			}
 		}
+		if (accumCount > 0)  // 1 character remaining
+			appendBitsToBuffer(accumData, 6, seg->data, &seg->bitLength);
+	} else {  // Byte mode data is stored as is
+		assert(seg->mode == qrcodegen_Mode_BYTE);
+		if (len > 0)
+			memcpy(&seg->data[usedBytes], text, len * sizeof(seg->data[0]));
+		seg->bitLength = bitLen;
 	}
-	if (accumCount > 0)  // 1 character remaining
-		appendBitsToBuffer(accumData, 6, buf, &result.bitLength);
-	assert(result.bitLength == bitLen);
-	result.data = buf;
-	return result;
+	seg->numChars += (int)len;
+	assert(seg->bitLength == bitLen);
 }
 
 
@@ -1014,10 +1464,10 @@ static int numCharCountBits(enum qrcodegen_Mode mode, int version) {
 	assert(qrcodegen_VERSION_MIN <= version && version <= qrcodegen_VERSION_MAX);
 	int i = (version + 7) / 17;
 	switch (mode) {
-		case qrcodegen_Mode_NUMERIC     : { static const int temp[] = {10, 12, 14}; return temp[i]; }
-		case qrcodegen_Mode_ALPHANUMERIC: { static const int temp[] = { 9, 11, 13}; return temp[i]; }
-		case qrcodegen_Mode_BYTE        : { static const int temp[] = { 8, 16, 16}; return temp[i]; }
-		case qrcodegen_Mode_KANJI       : { static const int temp[] = { 8, 10, 12}; return temp[i]; }
+		case qrcodegen_Mode_NUMERIC     : return pgm_read_byte(&CHAR_COUNT_BITS[0][i]);
+		case qrcodegen_Mode_ALPHANUMERIC: return pgm_read_byte(&CHAR_COUNT_BITS[1][i]);
+		case qrcodegen_Mode_BYTE        : return pgm_read_byte(&CHAR_COUNT_BITS[2][i]);
+		case qrcodegen_Mode_KANJI       : return pgm_read_byte(&CHAR_COUNT_BITS[3][i]);
 		case qrcodegen_Mode_ECI         : return 0;
 		default:  assert(false);  return -1;  // Dummy value
 	}
@@ -1025,3 +1475,9 @@ static int numCharCountBits(enum qrcodegen_Mode mode, int version) {
 
 
 #undef LENGTH_OVERFLOW
+#undef SEGMENT_BITS_PER_STEP
+#undef ROWS_PER_STEP
+#undef NOT_ALPHANUMERIC
+#undef getAlphanumericIndex
+#undef getEccCodewordsPerBlock
+#undef getNumErrorCorrectionBlocks
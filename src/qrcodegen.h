@@ -28,6 +28,11 @@
 #include <stdint.h>
 
 
+// Define QRCODE_STATS here (uncomment the line below) to record how long each encoding phase takes
+// See qrcodegen_Stats and QRCodeGenerator::getLastStats(); without it, no instrumentation code is compiled at all
+//#define QRCODE_STATS
+
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -126,6 +131,97 @@ struct qrcodegen_Segment {
 };
 
 
+/* 
+ * The result of scanning a text string once with qrcodegen_analyzeText().
+ * It lets the caller pick a version with qrcodegen_getMinVersion() and then
+ * encode with qrcodegen_encodeAnalyzedText() without rescanning the text.
+ */
+struct qrcodegen_TextInfo {
+	// The number of bytes in the text, excluding the NUL terminator.
+	size_t length;
+	
+	// The most compact mode that can encode the whole text: numeric,
+	// alphanumeric, or byte. An empty text is reported as numeric.
+	enum qrcodegen_Mode mode;
+};
+
+
+/* 
+ * Lets qrcodegen_encodeSegmentsParallel() evaluate the 8 mask patterns concurrently.
+ * The library itself never creates threads; parallelFor is provided by the caller
+ * (std::thread, pthreads, FreeRTOS tasks...).
+ */
+struct qrcodegen_MaskExecutor {
+	// Must call task(index, worker, taskContext) once for every index in [0, count),
+	// possibly concurrently, and return only after all of them have finished. Each call must
+	// get the number of the worker running it, in [0, workerCount); calls running at the
+	// same time must have different worker numbers.
+	void (*parallelFor)(int count, void (*task)(int index, int worker, void *taskContext),
+		void *taskContext, void *executorContext);
+	
+	// Passed as is to parallelFor.
+	void *executorContext;
+	
+	// The number of workers, which is also the number of grid copies in maskBuffers. Requires workerCount >= 1.
+	int workerCount;
+};
+
+
+/* 
+ * The stages of a resumable encode, in the order they run. Each call to
+ * qrcodegen_encodeStep() does a bounded amount of work and may move to the next stage.
+ */
+enum qrcodegen_EncodePhase {
+	qrcodegen_EncodePhase_SEGMENTS = 0,  // Concatenating the segments into the data bit string
+	qrcodegen_EncodePhase_ECC,           // Computing the error correction of one block per step
+	qrcodegen_EncodePhase_PLACEMENT,     // Drawing the function modules and the codewords
+	qrcodegen_EncodePhase_MASK_TRIAL,    // Scoring one mask pattern per step (automatic mask only)
+	qrcodegen_EncodePhase_FINAL_MASK,    // Applying the chosen mask and the format bits
+	qrcodegen_EncodePhase_DONE,          // The QR Code is complete
+};
+
+
+/* 
+ * Receives the rows of a QR Code as the final mask is applied, see qrcodegen_setRowSink().
+ * Row y (0 at the top) has size modules, packed with the leftmost one in the most significant
+ * bit of modules[0]; a 1 bit is a dark module. The array is only valid during the call.
+ */
+typedef void (*qrcodegen_RowSink)(int y, const uint8_t modules[], int size, void *context);
+
+
+// Counters of one encode, defined below when QRCODE_STATS is defined
+struct qrcodegen_Stats;
+
+
+/* 
+ * The state of a resumable encode, started by qrcodegen_beginEncode(). It holds no
+ * buffers of its own, only pointers to the caller's. All fields are private to the library.
+ */
+struct qrcodegen_Encoder {
+	const struct qrcodegen_Segment *segs;
+	size_t len;
+	uint8_t *tempBuffer;
+	uint8_t *qrcode;
+	enum qrcodegen_Ecc ecl;
+	enum qrcodegen_Mask mask;
+	enum qrcodegen_EncodePhase phase;
+	int version;
+	int dataUsedBits;
+	int bitLen;
+	int segIndex;
+	int segBit;      // -1 before the segment header is written
+	int counter;     // Block, sub-step or mask number, depending on the phase
+	int dataOffset;  // Offset of the next data block
+	long minPenalty;
+	uint8_t rsdiv[30];
+	qrcodegen_RowSink rowSink;  // NULL unless set by qrcodegen_setRowSink()
+	void *rowSinkContext;
+	bool keepGrid;
+	int nextRow;                // Next row for the sink
+	struct qrcodegen_Stats *stats;  // NULL unless given to qrcodegen_beginEncode()
+};
+
+
 
 /*---- Macro constants and functions ----*/
 
@@ -188,6 +284,20 @@ bool qrcodegen_encodeText(const char *text, uint8_t tempBuffer[], uint8_t qrcode
 	enum qrcodegen_Ecc ecl, int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl);
 
 
+/* 
+ * Encodes the given text string to a QR Code, like qrcodegen_encodeText(), but reusing
+ * the length and mode found by an earlier call to qrcodegen_analyzeText(), so the text
+ * is not scanned again. Only text[0 : info->length] is read, so a NUL terminator is not
+ * required. The info must describe exactly this text, otherwise the behavior is undefined.
+ * The text may be stored inside the qrcode array (but not inside tempBuffer), because
+ * it is fully consumed before the qrcode array is written. This lets a caller collect
+ * the text in its output buffer. All other arguments and results are the same as in
+ * qrcodegen_encodeText().
+ */
+bool qrcodegen_encodeAnalyzedText(const char *text, const struct qrcodegen_TextInfo *info, uint8_t tempBuffer[],
+	uint8_t qrcode[], enum qrcodegen_Ecc ecl, int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl);
+
+
 /* 
  * Encodes the given binary data to a QR Code, returning true if successful.
  * If the data is too long to fit in any version in the given range
@@ -303,6 +413,102 @@ bool qrcodegen_encodeSegmentsAdvanced(const struct qrcodegen_Segment segs[], siz
 	int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl, uint8_t tempBuffer[], uint8_t qrcode[]);
 
 
+/* 
+ * Same as qrcodegen_encodeSegmentsAdvanced() with qrcodegen_Mask_AUTO, except that the 8 mask
+ * trials are spread over the workers of the given executor. Every worker applies its masks to
+ * its own copy of the grid, so the trials don't interfere. Ties are broken in favor of the lowest
+ * mask number, so the result is identical to the serial one, whatever the number of workers.
+ * This only pays off for large versions, where scoring a mask takes much longer than starting a task.
+ * 
+ * About maskBuffers: it holds executor->workerCount grid copies one after the other, each
+ * qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion) bytes long (so the array has a length of at least
+ * executor->workerCount * qrcodegen_BUFFER_LEN_FOR_VERSION(maxVersion)). It must not overlap tempBuffer
+ * or qrcode, can be uninitialized, and contains no useful data after the function returns.
+ * The requirements on the other arguments are the same as qrcodegen_encodeSegmentsAdvanced().
+ * If stats is not NULL, the encode adds its counters to it (see qrcodegen_Stats).
+ */
+bool qrcodegen_encodeSegmentsParallel(const struct qrcodegen_Segment segs[], size_t len, enum qrcodegen_Ecc ecl,
+	int minVersion, int maxVersion, bool boostEcl, uint8_t tempBuffer[], uint8_t qrcode[],
+	const struct qrcodegen_MaskExecutor *executor, uint8_t maskBuffers[], struct qrcodegen_Stats *stats);
+
+
+#ifdef QRCODE_STATS
+/* 
+ * Time (in microseconds) and number of calls of each encoding phase. The caller owns the
+ * counters and passes them to qrcodegen_beginEncode(), qrcodegen_encodeSegmentsParallel() or
+ * qrcodegen_getMinVersion(), which add to them; zero them (and set mask to -1) before the first
+ * call. Encodes given different counters never share them, whatever thread they run on.
+ * Only available when QRCODE_STATS is defined; otherwise the stats arguments are ignored.
+ * Parallel mask trials are timed as a whole.
+ */
+struct qrcodegen_Stats {
+	uint32_t versionMicros;    // qrcodegen_getMinVersion()
+	uint32_t segmentMicros;    // Building the data bit string from the segments
+	uint32_t eccMicros;        // Error correction and interleaving
+	uint32_t placementMicros;  // Function modules and codeword placement (drawCodewords)
+	uint32_t maskMicros;       // Applying masks (each trial and the final one)
+	uint32_t penaltyMicros;    // Scoring mask trials (getPenaltyScore)
+	uint16_t versionSearches;
+	uint16_t eccBlocks;
+	uint16_t maskApplications; // A serial trial counts twice, the mask is undone on the same grid
+	uint16_t penaltyScores;
+	int8_t version;            // Of the last encoded symbol, 0 if none
+	int8_t mask;               // Chosen for the last encoded symbol, -1 if none
+};
+#endif
+
+
+/* 
+ * Starts a resumable version of qrcodegen_encodeSegmentsAdvanced(), for callers that can't block
+ * for a whole encode (e.g. a cooperative loop on a microcontroller). This only chooses the version
+ * and ECC level; call qrcodegen_encodeStep() until it returns qrcodegen_EncodePhase_DONE to do
+ * the actual work. The finished QR Code is identical to the one qrcodegen_encodeSegmentsAdvanced()
+ * makes from the same arguments.
+ * 
+ * Returns false (and sets qrcode[0] to 0) if the data doesn't fit any version in the range,
+ * in which case there is nothing to step. The requirements on the arguments are the same as
+ * qrcodegen_encodeSegmentsAdvanced(), and they hold until the encode is done: the segments and
+ * both arrays must stay valid and must not be touched by the caller between steps.
+ * If stats is not NULL, every step adds its counters to it (see qrcodegen_Stats), so it
+ * must stay valid until the encode is done too.
+ */
+bool qrcodegen_beginEncode(struct qrcodegen_Encoder *enc, const struct qrcodegen_Segment segs[], size_t len,
+	enum qrcodegen_Ecc ecl, int minVersion, int maxVersion, enum qrcodegen_Mask mask, bool boostEcl,
+	uint8_t tempBuffer[], uint8_t qrcode[], struct qrcodegen_Stats *stats);
+
+
+/* 
+ * Does the next bounded piece of work of an encode started by qrcodegen_beginEncode(), and
+ * returns the phase the encoder is in afterwards. The longest step is one mask trial, scoring the
+ * whole grid once; the other steps are shorter. Calling it again once done has no effect.
+ */
+enum qrcodegen_EncodePhase qrcodegen_encodeStep(struct qrcodegen_Encoder *enc);
+
+
+/* 
+ * Makes the final mask step of an encode started by qrcodegen_beginEncode() hand each finished row
+ * to sink, top to bottom, as it is masked. This fuses the last pass of the encoder with the first
+ * pass of a renderer: the rows can be drawn right away, without reading the QR Code back.
+ * Must be called before the encoder reaches qrcodegen_EncodePhase_FINAL_MASK.
+ * 
+ * If keepGrid is true, the masked rows are also written back, so the finished qrcode array is the
+ * same as without a sink. If it is false, they are not: once done, qrcode still has a valid size
+ * (qrcodegen_getSize) but its modules are unmasked, so it must not be drawn or read with
+ * qrcodegen_getModule(). The array is still needed while encoding, but nothing needs to keep it after.
+ * 
+ * Rows are emitted a few at a time per step, and the time spent in the sink counts as mask time
+ * in the stats. Passing a NULL sink restores the default behavior.
+ */
+void qrcodegen_setRowSink(struct qrcodegen_Encoder *enc, qrcodegen_RowSink sink, void *context, bool keepGrid);
+
+
+/* 
+ * Returns a rough estimate of the work already done by the given encoder, from 0 to 100.
+ * It never decreases from one step to the next, and it is 100 only once the encode is done.
+ */
+int qrcodegen_getEncodeProgress(const struct qrcodegen_Encoder *enc);
+
+
 /* 
  * Tests whether the given string can be encoded as a segment in numeric mode.
  * A string is encodable iff each character is in the range 0 to 9.
@@ -318,6 +524,36 @@ bool qrcodegen_isNumeric(const char *text);
 bool qrcodegen_isAlphanumeric(const char *text);
 
 
+/* 
+ * Scans the given NUL-terminated string once and returns its length together with
+ * the most compact mode able to encode it. This is equivalent to calling strlen(),
+ * qrcodegen_isNumeric() and qrcodegen_isAlphanumeric(), but reads each character once.
+ */
+struct qrcodegen_TextInfo qrcodegen_analyzeText(const char *text);
+
+
+/* 
+ * Adds the characters text[0 : len] to an analysis of text that arrives in pieces,
+ * updating its length and mode in place. Start from a qrcodegen_TextInfo with
+ * length 0 and mode qrcodegen_Mode_NUMERIC, which describes the empty string.
+ * The text may contain NULs; they force byte mode like any other non-alphanumeric byte.
+ */
+void qrcodegen_extendTextInfo(struct qrcodegen_TextInfo *info, const char *text, size_t len);
+
+
+/* 
+ * Returns the smallest version in the range [minVersion, maxVersion] whose data capacity
+ * at the given ECC level can hold a single segment of numChars characters in the given
+ * mode, or 0 if no version in the range is big enough. The capacity is computed exactly
+ * from the standard's codeword tables, so the result is the same version that
+ * qrcodegen_encodeSegmentsAdvanced() would choose for that segment.
+ * Requires 1 <= minVersion <= maxVersion <= 40 and mode not being ECI.
+ * If stats is not NULL, the search is added to its counters (see qrcodegen_Stats).
+ */
+int qrcodegen_getMinVersion(enum qrcodegen_Mode mode, size_t numChars,
+	enum qrcodegen_Ecc ecl, int minVersion, int maxVersion, struct qrcodegen_Stats *stats);
+
+
 /* 
  * Returns the number of bytes (uint8_t) needed for the data buffer of a segment
  * containing the given number of characters using the given mode. Notes:
@@ -354,6 +590,26 @@ struct qrcodegen_Segment qrcodegen_makeNumeric(const char *digits, uint8_t buf[]
 struct qrcodegen_Segment qrcodegen_makeAlphanumeric(const char *text, uint8_t buf[]);
 
 
+/* 
+ * Returns an empty segment in numeric, alphanumeric or byte mode whose data will be
+ * stored in buf. Characters are added with qrcodegen_appendToSegment(), which lets
+ * a segment be built from text that is not available all at once, such as text
+ * read from flash memory or from a stream in small pieces.
+ */
+struct qrcodegen_Segment qrcodegen_beginSegment(enum qrcodegen_Mode mode, uint8_t buf[]);
+
+
+/* 
+ * Appends the characters text[0 : len] to the given segment, packing them into its data
+ * buffer according to its mode. The text needs no NUL terminator and must be encodable
+ * in the segment's mode. Every piece except the last one must have a length multiple
+ * of 3 for numeric segments and of 2 for alphanumeric segments, because the characters
+ * are packed in groups. The data buffer must have room for
+ * qrcodegen_calcSegmentBufferSize(mode, total number of characters) bytes.
+ */
+void qrcodegen_appendToSegment(struct qrcodegen_Segment *seg, const char *text, size_t len);
+
+
 /* 
  * Returns a segment representing an Extended Channel Interpretation
  * (ECI) designator with the given assignment value.
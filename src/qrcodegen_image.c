@@ -0,0 +1,522 @@
+/*
+ * QR Code image writers (C)
+ *
+ * Copyright © 2025 Jan K. S.
+ * MIT License
+ * https://github.com/wallysalami/QRCodeGFX
+ */
+
+#include "qrcodegen_image.h"
+
+#ifndef ARDUINO
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "qrcodegen.h"
+
+
+/*---- Forward declarations for private functions ----*/
+
+// Receives count identical scanlines of a raster image, each lineLen bytes long.
+typedef bool (*BandWriter)(const uint8_t line[], size_t lineLen, long count, void *state);
+
+// The state of a PNG being written. The compressed data waits in chunk[] until it fills an IDAT chunk.
+struct PngWriter {
+	qrcodegen_ImageSink sink;
+	void *context;
+	bool ok;
+	uint8_t chunk[4096];
+	size_t chunkLen;
+	uint32_t bitBuffer;
+	int bitCount;
+	uint32_t adlerA;
+	uint32_t adlerB;
+};
+
+// The state of an SVG being written. The text waits in text[] until it is full.
+struct SvgWriter {
+	qrcodegen_ImageSink sink;
+	void *context;
+	bool ok;
+	char text[256];
+	size_t textLen;
+};
+
+static int64_t getImageSide(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options);
+static bool getRotatedModule(const uint8_t qrcode[], int rotation, int x, int y);
+static bool writeBands(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options, int bitsPerPixel,
+	uint8_t lightByte, BandWriter writer, void *state);
+static bool writeText(qrcodegen_ImageSink sink, void *context, const char *format, ...);
+static bool writeRawBand(const uint8_t line[], size_t lineLen, long count, void *state);
+
+static bool writePngBand(const uint8_t line[], size_t lineLen, long count, void *state);
+static bool writePngChunk(qrcodegen_ImageSink sink, void *context, const char *type, const uint8_t data[], size_t len);
+static uint32_t updateCrc(uint32_t crc, const uint8_t data[], size_t len);
+static void flushPngChunk(struct PngWriter *w);
+static void putPngByte(struct PngWriter *w, uint8_t value);
+static void putPngBits(struct PngWriter *w, uint32_t value, int count);
+static void putPngCode(struct PngWriter *w, uint32_t code, int length);
+static void putPngSymbol(struct PngWriter *w, int symbol);
+static void putPngMatch(struct PngWriter *w, int length, int distance);
+static void putPngCopy(struct PngWriter *w, long length, int distance);
+static void updateAdler(struct PngWriter *w, const uint8_t data[], size_t len);
+
+static void printSvg(struct SvgWriter *w, const char *format, ...);
+static void flushSvg(struct SvgWriter *w);
+
+
+/*---- Private tables and constants ----*/
+
+// Raster images wider than this are refused, which keeps PNG scanlines within the deflate window.
+#define MAX_IMAGE_SIDE 65535
+
+// Deflate length codes 257 to 285: first length and number of extra bits.
+static const int LENGTH_BASE[29] = {3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+	35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258};
+static const int LENGTH_EXTRA_BITS[29] = {0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+	3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0};
+
+// Deflate distance codes 0 to 29: first distance and number of extra bits.
+static const int DISTANCE_BASE[30] = {1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+	257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577};
+static const int DISTANCE_EXTRA_BITS[30] = {0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+	7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13};
+
+
+
+/*---- Raster writers ----*/
+
+// Public function - see documentation comment in header file.
+bool qrcodegen_writePbm(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options,
+		qrcodegen_ImageSink sink, void *context) {
+	int64_t side = getImageSide(qrcode, options);
+	if (side < 0 || side > MAX_IMAGE_SIDE)
+		return false;
+	if (!writeText(sink, context, "P4\n%d %d\n", (int)side, (int)side))
+		return false;
+	void *state[2] = {(void *)sink, context};
+	return writeBands(qrcode, options, 1, 0x00, writeRawBand, state);
+}
+
+
+// Public function - see documentation comment in header file.
+bool qrcodegen_writePgm(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options,
+		qrcodegen_ImageSink sink, void *context) {
+	int64_t side = getImageSide(qrcode, options);
+	if (side < 0 || side > MAX_IMAGE_SIDE)
+		return false;
+	if (!writeText(sink, context, "P5\n%d %d\n255\n", (int)side, (int)side))
+		return false;
+	void *state[2] = {(void *)sink, context};
+	return writeBands(qrcode, options, 8, 0xFF, writeRawBand, state);
+}
+
+
+// Public function - see documentation comment in header file.
+bool qrcodegen_writePng(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options,
+		qrcodegen_ImageSink sink, void *context) {
+	int64_t side = getImageSide(qrcode, options);
+	if (side < 0 || side > MAX_IMAGE_SIDE)
+		return false;
+
+	static const uint8_t SIGNATURE[8] = {0x89, 'P', 'N', 'G', '\r', '\n', 0x1A, '\n'};
+	uint8_t header[13] = {0};
+	for (int i = 0; i < 4; i++) {
+		header[i] = (uint8_t)(side >> (24 - i * 8));  // Width
+		header[4 + i] = header[i];  // Height
+	}
+	header[8] = 1;  // Bit depth, color type 0 (grayscale), default compression, filter and no interlace
+	if (!sink(SIGNATURE, sizeof(SIGNATURE), context) || !writePngChunk(sink, context, "IHDR", header, sizeof(header)))
+		return false;
+
+	struct PngWriter *w = (struct PngWriter *)malloc(sizeof(struct PngWriter));
+	if (w == NULL)
+		return false;
+	w->sink = sink;
+	w->context = context;
+	w->ok = true;
+	w->chunkLen = 0;
+	w->bitBuffer = 0;
+	w->bitCount = 0;
+	w->adlerA = 1;
+	w->adlerB = 0;
+
+	// Zlib header (deflate, 32 KB window, no dictionary), then a single fixed Huffman block
+	putPngByte(w, 0x78);
+	putPngByte(w, 0x01);
+	putPngBits(w, 1, 1);  // Final block
+	putPngBits(w, 1, 2);  // Fixed Huffman codes
+	bool ok = writeBands(qrcode, options, 1, 0xFF, writePngBand, w);
+	if (ok) {
+		putPngSymbol(w, 256);  // End of block
+		putPngBits(w, 0, (8 - w->bitCount) % 8);
+		uint32_t adler = w->adlerB << 16 | w->adlerA;
+		for (int i = 24; i >= 0; i -= 8)
+			putPngByte(w, (uint8_t)(adler >> i));
+		flushPngChunk(w);
+		ok = w->ok && writePngChunk(sink, context, "IEND", NULL, 0);
+	}
+	free(w);
+	return ok;
+}
+
+
+// Returns the side of the image in pixels, or -1 if the options are invalid.
+static int64_t getImageSide(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options) {
+	if (qrcode == NULL || options == NULL || options->scale < 1 || options->border < 0
+			|| options->rotation < 0 || options->rotation > 3)
+		return -1;
+	return ((int64_t)qrcodegen_getSize(qrcode) + 2 * (int64_t)options->border) * options->scale;
+}
+
+
+// Returns the color of the module at (x, y) of the rotated QR Code, light if out of bounds.
+static bool getRotatedModule(const uint8_t qrcode[], int rotation, int x, int y) {
+	int last = qrcodegen_getSize(qrcode) - 1;
+	switch (rotation) {
+		case 1:   return qrcodegen_getModule(qrcode, y, last - x);
+		case 2:   return qrcodegen_getModule(qrcode, last - x, last - y);
+		case 3:   return qrcodegen_getModule(qrcode, last - y, x);
+		default:  return qrcodegen_getModule(qrcode, x, y);
+	}
+}
+
+
+// Builds each scanline of the image once and passes it to the writer with the number of times
+// it repeats: scale times for a row of modules, border times scale for each side of the quiet zone.
+// Pixels are 1 bit (packed most significant bit first) or 8 bits, light pixels are all ones or all
+// zeros as given by lightByte, and dark pixels are their complement.
+static bool writeBands(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options, int bitsPerPixel,
+		uint8_t lightByte, BandWriter writer, void *state) {
+	int size = qrcodegen_getSize(qrcode);
+	int scale = options->scale;
+	int border = options->border;
+	size_t side = ((size_t)size + 2 * (size_t)border) * (size_t)scale;
+	size_t lineLen = bitsPerPixel == 1 ? (side + 7) / 8 : side;
+	uint8_t *line = (uint8_t *)malloc(lineLen);
+	if (line == NULL)
+		return false;
+
+	bool ok = true;
+	for (int y = -border; ok && y < size + border; ) {
+		int rows = y < 0 || y >= size ? border : 1;
+		memset(line, lightByte, lineLen);
+		for (int x = 0; x < size; x++) {
+			if (!getRotatedModule(qrcode, options->rotation, x, y))
+				continue;
+			size_t start = ((size_t)border + (size_t)x) * (size_t)scale;
+			for (size_t i = start; i < start + (size_t)scale; i++) {
+				if (bitsPerPixel == 1)
+					line[i >> 3] ^= (uint8_t)(0x80 >> (i & 7));
+				else
+					line[i] ^= 0xFF;
+			}
+		}
+		ok = writer(line, lineLen, (long)rows * scale, state);
+		y += rows;
+	}
+	free(line);
+	return ok;
+}
+
+
+// Formats a short header and passes it to the sink.
+static bool writeText(qrcodegen_ImageSink sink, void *context, const char *format, ...) {
+	char text[64];
+	va_list args;
+	va_start(args, format);
+	int len = vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	return len > 0 && (size_t)len < sizeof(text) && sink(text, (size_t)len, context);
+}
+
+
+// Band writer for PBM and PGM, whose pixels are stored as they are. The state holds the sink and its context.
+static bool writeRawBand(const uint8_t line[], size_t lineLen, long count, void *state) {
+	void **sinkAndContext = (void **)state;
+	qrcodegen_ImageSink sink = (qrcodegen_ImageSink)sinkAndContext[0];
+	for (long i = 0; i < count; i++) {
+		if (!sink(line, lineLen, sinkAndContext[1]))
+			return false;
+	}
+	return true;
+}
+
+
+
+/*---- PNG encoding ----*/
+
+// Band writer for PNG. Each scanline starts with filter type 0 (none). The first one is
+// compressed on its own, with runs of a repeated byte as references to the byte before;
+// the repeats are a single reference to the scanline above.
+static bool writePngBand(const uint8_t line[], size_t lineLen, long count, void *state) {
+	struct PngWriter *w = (struct PngWriter *)state;
+	const uint8_t filter = 0;
+	for (long i = 0; i < count; i++) {
+		updateAdler(w, &filter, 1);
+		updateAdler(w, line, lineLen);
+	}
+
+	putPngSymbol(w, filter);
+	for (size_t i = 0; i < lineLen; ) {
+		size_t run = 0;
+		while (i > 0 && i + run < lineLen && line[i + run] == line[i - 1])
+			run++;
+		if (run >= 3) {
+			putPngCopy(w, (long)run, 1);
+			i += run;
+		} else {
+			putPngSymbol(w, line[i]);
+			i++;
+		}
+	}
+
+	long repeated = (count - 1) * (long)(lineLen + 1);
+	if (repeated >= 3)
+		putPngCopy(w, repeated, (int)lineLen + 1);
+	else if (repeated > 0) {  // A single 1 byte scanline, too short for a reference
+		putPngSymbol(w, filter);
+		putPngSymbol(w, line[0]);
+	}
+	return w->ok;
+}
+
+
+// Sends a PNG chunk: length, type, data and the CRC of the type and data.
+static bool writePngChunk(qrcodegen_ImageSink sink, void *context, const char *type, const uint8_t data[], size_t len) {
+	uint8_t header[8];
+	for (int i = 0; i < 4; i++) {
+		header[i] = (uint8_t)(len >> (24 - i * 8));
+		header[4 + i] = (uint8_t)type[i];
+	}
+	uint32_t crc = updateCrc(0xFFFFFFFF, &header[4], 4);
+	crc = updateCrc(crc, data, len) ^ 0xFFFFFFFF;
+	uint8_t footer[4] = {(uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc};
+	return sink(header, sizeof(header), context)
+		&& (len == 0 || sink(data, len, context))
+		&& sink(footer, sizeof(footer), context);
+}
+
+
+// Updates a CRC-32 (as used by PNG) with the given bytes, bit by bit. The compressed data is small.
+static uint32_t updateCrc(uint32_t crc, const uint8_t data[], size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		crc ^= data[i];
+		for (int j = 0; j < 8; j++)
+			crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+	}
+	return crc;
+}
+
+
+// Sends the compressed data collected so far as an IDAT chunk.
+static void flushPngChunk(struct PngWriter *w) {
+	if (w->ok && w->chunkLen > 0)
+		w->ok = writePngChunk(w->sink, w->context, "IDAT", w->chunk, w->chunkLen);
+	w->chunkLen = 0;
+}
+
+
+static void putPngByte(struct PngWriter *w, uint8_t value) {
+	w->chunk[w->chunkLen] = value;
+	w->chunkLen++;
+	if (w->chunkLen == sizeof(w->chunk))
+		flushPngChunk(w);
+}
+
+
+// Appends the low count bits of value to the deflate stream, least significant bit first.
+static void putPngBits(struct PngWriter *w, uint32_t value, int count) {
+	w->bitBuffer |= value << w->bitCount;
+	w->bitCount += count;
+	while (w->bitCount >= 8) {
+		putPngByte(w, (uint8_t)w->bitBuffer);
+		w->bitBuffer >>= 8;
+		w->bitCount -= 8;
+	}
+}
+
+
+// Appends a Huffman code, which deflate stores most significant bit first.
+static void putPngCode(struct PngWriter *w, uint32_t code, int length) {
+	uint32_t reversed = 0;
+	for (int i = 0; i < length; i++)
+		reversed |= ((code >> i) & 1) << (length - 1 - i);
+	putPngBits(w, reversed, length);
+}
+
+
+// Appends a literal (0 to 255), the end of block (256) or a length code (257 to 285) with the fixed Huffman codes.
+static void putPngSymbol(struct PngWriter *w, int symbol) {
+	if (symbol < 144)
+		putPngCode(w, 0x30 + (uint32_t)symbol, 8);
+	else if (symbol < 256)
+		putPngCode(w, 0x190 + (uint32_t)(symbol - 144), 9);
+	else if (symbol < 280)
+		putPngCode(w, (uint32_t)(symbol - 256), 7);
+	else
+		putPngCode(w, 0xC0 + (uint32_t)(symbol - 280), 8);
+}
+
+
+// Appends a reference to the length bytes starting distance bytes back, with 3 <= length <= 258.
+static void putPngMatch(struct PngWriter *w, int length, int distance) {
+	int i = 28;
+	while (LENGTH_BASE[i] > length)
+		i--;
+	putPngSymbol(w, 257 + i);
+	putPngBits(w, (uint32_t)(length - LENGTH_BASE[i]), LENGTH_EXTRA_BITS[i]);
+
+	int j = 29;
+	while (DISTANCE_BASE[j] > distance)
+		j--;
+	putPngCode(w, (uint32_t)j, 5);
+	putPngBits(w, (uint32_t)(distance - DISTANCE_BASE[j]), DISTANCE_EXTRA_BITS[j]);
+}
+
+
+// Appends a reference of any length (at least 3) as a series of matches. When the length is
+// larger than the distance, the referenced bytes repeat, which is how scanlines are repeated.
+static void putPngCopy(struct PngWriter *w, long length, int distance) {
+	while (length > 0) {
+		int part = length > 258 ? 258 : (int)length;
+		if (length - part > 0 && length - part < 3)
+			part = (int)length - 3;  // Leave enough for one more match
+		putPngMatch(w, part, distance);
+		length -= part;
+	}
+}
+
+
+// Updates the Adler-32 checksum of the uncompressed data, which ends the zlib stream.
+static void updateAdler(struct PngWriter *w, const uint8_t data[], size_t len) {
+	for (size_t i = 0; i < len; i++) {
+		w->adlerA = (w->adlerA + data[i]) % 65521;
+		w->adlerB = (w->adlerB + w->adlerA) % 65521;
+	}
+}
+
+
+
+/*---- SVG writer ----*/
+
+// Public function - see documentation comment in header file.
+bool qrcodegen_writeSvg(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options,
+		qrcodegen_ImageSink sink, void *context) {
+	int64_t pixels = getImageSide(qrcode, options);
+	if (pixels < 0 || pixels > INT32_MAX)
+		return false;
+	int size = qrcodegen_getSize(qrcode);
+	int border = options->border;
+	int side = size + 2 * border;
+
+	struct SvgWriter w;
+	w.sink = sink;
+	w.context = context;
+	w.ok = true;
+	w.textLen = 0;
+	printSvg(&w, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n");
+	printSvg(&w, "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\" width=\"%ld\" height=\"%ld\" ",
+		(long)pixels, (long)pixels);
+	printSvg(&w, "viewBox=\"0 0 %d %d\" shape-rendering=\"crispEdges\">\n", side, side);
+	printSvg(&w, "\t<rect width=\"100%%\" height=\"100%%\" fill=\"#FFFFFF\"/>\n");
+	printSvg(&w, "\t<path fill=\"#000000\" d=\"");
+	for (int y = 0; y < size && w.ok; y++) {
+		for (int x = 0; x < size; ) {
+			if (!getRotatedModule(qrcode, options->rotation, x, y)) {
+				x++;
+				continue;
+			}
+			int run = 1;
+			while (x + run < size && getRotatedModule(qrcode, options->rotation, x + run, y))
+				run++;
+			printSvg(&w, "M%d,%dh%dv1h-%dz", border + x, border + y, run, run);
+			x += run;
+		}
+	}
+	printSvg(&w, "\"/>\n</svg>\n");
+	flushSvg(&w);
+	return w.ok;
+}
+
+
+// Formats a piece of the SVG into the text buffer, sending the buffer first if the piece doesn't fit.
+static void printSvg(struct SvgWriter *w, const char *format, ...) {
+	for (int attempt = 0; attempt < 2 && w->ok; attempt++) {
+		size_t room = sizeof(w->text) - w->textLen;
+		va_list args;
+		va_start(args, format);
+		int len = vsnprintf(&w->text[w->textLen], room, format, args);
+		va_end(args);
+		if (len >= 0 && (size_t)len < room) {
+			w->textLen += (size_t)len;
+			return;
+		}
+		flushSvg(w);
+	}
+	w->ok = false;  // Longer than the whole buffer, which none of the pieces are
+}
+
+
+static void flushSvg(struct SvgWriter *w) {
+	if (w->ok && w->textLen > 0)
+		w->ok = w->sink(w->text, w->textLen, w->context);
+	w->textLen = 0;
+}
+
+
+
+/*---- Symbol files ----*/
+
+// Public function - see documentation comment in header file.
+bool qrcodegen_writeSymbol(const uint8_t qrcode[], qrcodegen_ImageSink sink, void *context) {
+	int size = qrcodegen_getSize(qrcode);
+
+	// Error correction level and mask from the first copy of the format information,
+	// whose levels are ordered M, L, H, Q (against L, M, Q, H in the file)
+	int format = 0;
+	for (int i = 0; i < 15; i++) {
+		bool bit = i < 6 ? qrcodegen_getModule(qrcode, 8, i)
+			: i < 8 ? qrcodegen_getModule(qrcode, 8, i + 1)
+			: i == 8 ? qrcodegen_getModule(qrcode, 7, 8)
+			: qrcodegen_getModule(qrcode, 14 - i, 8);
+		format |= (int)bit << i;
+	}
+	format = (format ^ 0x5412) >> 10;
+
+	uint8_t header[7] = {'Q', 'R', 'C', 1, (uint8_t)((size - 17) / 4), (uint8_t)((format >> 3) ^ 1), (uint8_t)(format & 7)};
+	uint32_t crc = updateCrc(0xFFFFFFFF, header, sizeof(header));
+	if (!sink(header, sizeof(header), context))
+		return false;
+
+	// Rows with the leftmost module in the most significant bit
+	uint8_t row[(qrcodegen_VERSION_MAX * 4 + 17 + 7) / 8];
+	size_t rowLen = (size_t)(size + 7) / 8;
+	for (int y = 0; y < size; y++) {
+		memset(row, 0, rowLen);
+		for (int x = 0; x < size; x++) {
+			if (qrcodegen_getModule(qrcode, x, y))
+				row[x >> 3] |= 0x80 >> (x & 7);
+		}
+		crc = updateCrc(crc, row, rowLen);
+		if (!sink(row, rowLen, context))
+			return false;
+	}
+
+	crc ^= 0xFFFFFFFF;
+	uint8_t trailer[4] = {(uint8_t)(crc >> 24), (uint8_t)(crc >> 16), (uint8_t)(crc >> 8), (uint8_t)crc};
+	return sink(trailer, sizeof(trailer), context);
+}
+
+
+
+/*---- Files ----*/
+
+// Public function - see documentation comment in header file.
+bool qrcodegen_writeToFile(const void *data, size_t length, void *context) {
+	return fwrite(data, 1, length, (FILE *)context) == length;
+}
+
+#endif
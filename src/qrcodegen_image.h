@@ -0,0 +1,117 @@
+/*
+ * QR Code image writers (C)
+ *
+ * Copyright © 2025 Jan K. S.
+ * MIT License
+ * https://github.com/wallysalami/QRCodeGFX
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+
+// These writers are meant for servers and desktop tools that use the C core on its own
+// They are not compiled for boards, which have no files and little RAM to spare
+#ifndef ARDUINO
+
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+/*
+ * Turns an encoded QR Code (see qrcodegen.h) into an image file, written piece by piece
+ * through a callback, from top to bottom. The scaled image is never held in memory:
+ * the raster writers keep a single scanline, so a version 40 QR Code at scale 20
+ * (3700 pixels wide with a 4 module quiet zone) needs about 500 bytes of buffer.
+ *
+ * Dark modules are black and light modules (and the quiet zone) are white.
+ */
+
+
+/*---- Types ----*/
+
+/*
+ * Receives the next length bytes of the image. Returns false to stop writing
+ * (the writer then returns false as well). The data is only valid during the call.
+ */
+typedef bool (*qrcodegen_ImageSink)(const void *data, size_t length, void *context);
+
+
+/*
+ * How a QR Code is laid out in the image.
+ */
+struct qrcodegen_ImageOptions {
+	int scale;     // Pixels per module side, at least 1
+	int border;    // Quiet zone around the symbol, in modules (the standard asks for 4)
+	int rotation;  // Clockwise quarter turns, from 0 to 3 (the values of QRCodeRotation)
+};
+
+
+/*---- Functions ----*/
+
+/*
+ * Writes the QR Code as a raw (binary) PBM file, 1 bit per pixel.
+ * Returns false if the options are invalid, the image would be more than 65535 pixels
+ * wide, the scanline can't be allocated or the sink stops the writing.
+ */
+bool qrcodegen_writePbm(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options,
+	qrcodegen_ImageSink sink, void *context);
+
+
+/*
+ * Writes the QR Code as a raw (binary) PGM file, 8 bits per pixel.
+ * It is 8 times larger than the PBM, but more tools read it. Fails like qrcodegen_writePbm().
+ */
+bool qrcodegen_writePgm(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options,
+	qrcodegen_ImageSink sink, void *context);
+
+
+/*
+ * Writes the QR Code as a 1 bit grayscale PNG file. The image data is compressed with a
+ * single fixed Huffman deflate block: runs of identical bytes and repeated scanlines become
+ * back references, so there is no dependency on zlib. A version 40 QR Code at scale 20 takes
+ * about 60 KB, against 1.7 MB of raw pixels. The output is sent in IDAT chunks of up to 4 KB,
+ * which the writer allocates on the heap. Fails like qrcodegen_writePbm().
+ */
+bool qrcodegen_writePng(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options,
+	qrcodegen_ImageSink sink, void *context);
+
+
+/*
+ * Writes the QR Code as an SVG file, with the dark modules in a single path. Each horizontal
+ * run of dark modules is one rectangle of the path, in module units (the scale only sets the
+ * width and height of the image). Returns false if the options are invalid or the sink stops
+ * the writing. No memory is allocated.
+ */
+bool qrcodegen_writeSvg(const uint8_t qrcode[], const struct qrcodegen_ImageOptions *options,
+	qrcodegen_ImageSink sink, void *context);
+
+
+/*
+ * Writes the QR Code as a symbol record for QRCodeFile (see QRCodeFile.h): a 7 byte header
+ * with the version, error correction level and mask, the module rows (1 bit per module,
+ * each row padded to whole bytes) and a CRC-32. Boards read it from an SD card or flash file
+ * system and draw it without encoding. Records can be appended to the same file one after
+ * the other. Returns false if the sink stops the writing. No memory is allocated.
+ */
+bool qrcodegen_writeSymbol(const uint8_t qrcode[], qrcodegen_ImageSink sink, void *context);
+
+
+/*
+ * An image sink that writes to a stdio file, given as the context (a FILE pointer):
+ *   FILE *file = fopen("qrcode.png", "wb");
+ *   qrcodegen_writePng(qrcode, &options, qrcodegen_writeToFile, file);
+ */
+bool qrcodegen_writeToFile(const void *data, size_t length, void *context);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif